@@ -17,9 +17,41 @@ cbuffer ViewUB : register(b0)
 cbuffer ObjUB : register(b1)
 {
 	float4x4 Obj;
+
+	// Dequantizes POSITION (1/0 for float vertices)
+	float3 PosScale;
+
+	// What COLOR holds, EObjVertexFormat: 0 packed normal, 1 octahedral normal, 2 tangent frame quaternion
+	uint NormalEncoding;
+
+	float3 PosBias;
 };
 
-FVSOut Main(float3 Pos : POSITION, float2 UV : TEXCOORD0, uint VertexID : SV_VertexID)
+float3 DecodeOctahedral(float2 E)
+{
+	float3 N = float3(E.xy, 1 - abs(E.x) - abs(E.y));
+	float T = max(-N.z, 0);
+	N.xy += N.xy >= 0 ? -T : T;
+	return normalize(N);
+}
+
+float3 RotateByQuaternion(float4 Q, float3 V)
+{
+	return V + 2 * cross(Q.xyz, cross(Q.xyz, V) + Q.w * V);
+}
+
+// Tangent and bitangent sign (w) of a tangent frame quaternion; the normal is DecodeTangentFrameNormal()
+float4 DecodeTangentFrameTangent(float4 Q)
+{
+	return float4(RotateByQuaternion(normalize(Q), float3(1, 0, 0)), Q.w < 0 ? -1 : 1);
+}
+
+float3 DecodeTangentFrameNormal(float4 Q)
+{
+	return RotateByQuaternion(normalize(Q), float3(0, 0, 1));
+}
+
+FVSOut Main(float3 Pos : POSITION, float4 Color : COLOR, float2 UV : TEXCOORD0, uint VertexID : SV_VertexID)
 {
 	//float3 P[3] =
 	//{
@@ -40,7 +72,7 @@ FVSOut Main(float3 Pos : POSITION, float2 UV : TEXCOORD0, uint VertexID : SV_Ver
 	
 	FVSOut Out = (FVSOut)0;
 	//Out.Pos = float4(P[VertexID % 3], 1);
-	Out.Pos = float4(Pos, 1);
+	Out.Pos = float4(Pos * PosScale + PosBias, 1);
 
 	#if !USE_VIEW_UB
 	#if 1
@@ -78,6 +110,17 @@ FVSOut Main(float3 Pos : POSITION, float2 UV : TEXCOORD0, uint VertexID : SV_Ver
 	#endif
 	Out.Pos = mul(Proj, Out.Pos);
 	Out.UVs = UV;
+
+	float3 Normal = Color.xyz * 2 - 1;
+	if (NormalEncoding == 1)
+	{
+		Normal = DecodeOctahedral(Color.xy);
+	}
+	else if (NormalEncoding == 2)
+	{
+		Normal = DecodeTangentFrameNormal(Color);
+	}
+	Out.Color = float4(Normal * 0.5 + 0.5, 1);
 	
 	return Out;
 }
@@ -0,0 +1,913 @@
+// Offset/size bookkeeping for GPU memory, without any API calls so it can be tested and benchmarked anywhere
+// (Tests/AllocatorsTest.cpp). Only include Core.h and the standard library here; no windows.h, min()/max() macros.
+
+#pragma once
+
+#include "Core.h"
+#include <map>
+#include <deque>
+#include <string>
+#include <stdio.h>
+#include <vector>
+
+struct FTLSFStats
+{
+	uint64 Size = 0;
+	uint64 UsedBytes = 0;
+	uint32 NumAllocations = 0;
+
+	uint64 FreeBytes = 0;
+	uint32 NumFreeBlocks = 0;
+	uint64 LargestFreeBlock = 0;
+
+	// 0 when all free memory is one block, close to 1 when it's scattered in small pieces
+	float GetFragmentation() const
+	{
+		return FreeBytes ? 1.0f - (float)((double)LargestFreeBlock / (double)FreeBytes) : 0.0f;
+	}
+};
+
+// Two level segregated fit over [0, Size): free blocks are bucketed by their top set bit and the SL_BITS bits below it,
+// with a bitmap per level, so finding a free block at least as big as asked for is a couple of bit scans. Blocks know
+// their physical neighbours, so freeing merges with them right away. Both are O(1).
+class FTLSFAllocator
+{
+public:
+	enum
+	{
+		SL_BITS = 5,
+		SL_COUNT = 1 << SL_BITS,
+
+		// Sizes under SL_COUNT all go in the first level; every top bit from SL_BITS up gets its own
+		FL_COUNT = 64 - SL_BITS + 1,
+	};
+
+	static const uint32 INVALID_BLOCK = (uint32)-1;
+
+	void Create(uint64 InSize)
+	{
+		check(InSize > 0);
+		Size = InSize;
+		UsedBytes = 0;
+		NumAllocations = 0;
+		Blocks.clear();
+		FirstUnusedBlock = INVALID_BLOCK;
+		FLBitmap = 0;
+		MemZero(SLBitmaps);
+		for (uint32 FL = 0; FL < FL_COUNT; ++FL)
+		{
+			for (uint32 SL = 0; SL < SL_COUNT; ++SL)
+			{
+				FreeLists[FL][SL] = INVALID_BLOCK;
+			}
+		}
+
+		uint32 Block = NewBlock(0, InSize);
+		InsertFree(Block);
+	}
+
+	// Returns a block to pass to Free(), or INVALID_BLOCK if there is no free block big enough
+	uint32 Alloc(uint64 InSize, uint64 Alignment, uint64& OutOffset)
+	{
+		check(InSize > 0 && IsPowerOfTwo(Alignment));
+
+		// The first block of the right size class is very likely aligned already (all sizes here are multiples of the
+		// common alignments); only if it isn't pay for a worst case search that leaves room to align
+		uint32 Block = FindFree(InSize);
+		if (Block != INVALID_BLOCK && !Fits(Block, InSize, Alignment))
+		{
+			Block = FindFree(InSize + Alignment - 1);
+		}
+		if (Block == INVALID_BLOCK)
+		{
+			// Rounding up to the next list skips blocks in InSize's own list that are big enough, eg one free block
+			// exactly as big as the request, so walk that list before giving up
+			Block = FindFreeInList(InSize, Alignment);
+			if (Block == INVALID_BLOCK)
+			{
+				return INVALID_BLOCK;
+			}
+		}
+		RemoveFree(Block);
+
+		// Leave what the alignment skipped as a free block in front
+		const uint64 Offset = Align(Blocks[Block].Offset, Alignment);
+		if (Offset > Blocks[Block].Offset)
+		{
+			const uint32 Front = Block;
+			Block = Split(Front, Offset - Blocks[Front].Offset);
+			InsertFree(Front);
+		}
+		if (Blocks[Block].Size > InSize)
+		{
+			InsertFree(Split(Block, InSize));
+		}
+
+		Blocks[Block].bFree = false;
+		UsedBytes += InSize;
+		++NumAllocations;
+		OutOffset = Offset;
+		return Block;
+	}
+
+	void Free(uint32 Block)
+	{
+		check(Block < (uint32)Blocks.size() && !Blocks[Block].bFree && NumAllocations > 0);
+		UsedBytes -= Blocks[Block].Size;
+		--NumAllocations;
+
+		const uint32 Next = Blocks[Block].NextPhysical;
+		if (Next != INVALID_BLOCK && Blocks[Next].bFree)
+		{
+			RemoveFree(Next);
+			Merge(Block, Next);
+		}
+		const uint32 Prev = Blocks[Block].PrevPhysical;
+		if (Prev != INVALID_BLOCK && Blocks[Prev].bFree)
+		{
+			RemoveFree(Prev);
+			Merge(Prev, Block);
+			Block = Prev;
+		}
+		InsertFree(Block);
+	}
+
+	uint64 GetOffset(uint32 Block) const
+	{
+		return Blocks[Block].Offset;
+	}
+
+	uint64 GetSize() const
+	{
+		return Size;
+	}
+
+	uint64 GetUsed() const
+	{
+		return UsedBytes;
+	}
+
+	uint32 GetNumAllocations() const
+	{
+		return NumAllocations;
+	}
+
+	bool IsEmpty() const
+	{
+		return NumAllocations == 0;
+	}
+
+	// Walks the free lists, so not meant for every allocation
+	FTLSFStats GetStats() const
+	{
+		FTLSFStats Stats;
+		Stats.Size = Size;
+		Stats.UsedBytes = UsedBytes;
+		Stats.NumAllocations = NumAllocations;
+		for (uint32 FL = 0; FL < FL_COUNT; ++FL)
+		{
+			for (uint32 SL = 0; SL < SL_COUNT; ++SL)
+			{
+				for (uint32 Block = FreeLists[FL][SL]; Block != INVALID_BLOCK; Block = Blocks[Block].NextFree)
+				{
+					Stats.FreeBytes += Blocks[Block].Size;
+					++Stats.NumFreeBlocks;
+					if (Blocks[Block].Size > Stats.LargestFreeBlock)
+					{
+						Stats.LargestFreeBlock = Blocks[Block].Size;
+					}
+				}
+			}
+		}
+		return Stats;
+	}
+
+protected:
+	struct FBlock
+	{
+		uint64 Offset;
+		uint64 Size;
+		uint32 PrevPhysical;
+		uint32 NextPhysical;
+
+		// Free list links; NextFree also chains unused entries of Blocks
+		uint32 PrevFree;
+		uint32 NextFree;
+		bool bFree;
+	};
+
+	uint64 Size = 0;
+	uint64 UsedBytes = 0;
+	uint32 NumAllocations = 0;
+
+	std::vector<FBlock> Blocks;
+	uint32 FirstUnusedBlock = INVALID_BLOCK;
+
+	uint64 FLBitmap = 0;
+	uint32 SLBitmaps[FL_COUNT];
+	uint32 FreeLists[FL_COUNT][SL_COUNT];
+
+	static void GetLists(uint64 InSize, uint32& OutFL, uint32& OutSL)
+	{
+		if (InSize < SL_COUNT)
+		{
+			OutFL = 0;
+			OutSL = (uint32)InSize;
+		}
+		else
+		{
+			const uint32 TopBit = GetHighestSetBit(InSize);
+			OutFL = TopBit - SL_BITS + 1;
+			OutSL = (uint32)(InSize >> (TopBit - SL_BITS)) - SL_COUNT;
+		}
+	}
+
+	// Any block in the list found is at least InSize, as the size is rounded up to the next list first
+	uint32 FindFree(uint64 InSize) const
+	{
+		if (InSize >= SL_COUNT)
+		{
+			InSize += ((uint64)1 << (GetHighestSetBit(InSize) - SL_BITS)) - 1;
+		}
+		uint32 FL, SL;
+		GetLists(InSize, FL, SL);
+		if (FL >= FL_COUNT)
+		{
+			return INVALID_BLOCK;
+		}
+
+		uint32 SLMap = SLBitmaps[FL] & (~0u << SL);
+		if (!SLMap)
+		{
+			const uint64 FLMap = (FL + 1 < FL_COUNT) ? FLBitmap & (~(uint64)0 << (FL + 1)) : 0;
+			if (!FLMap)
+			{
+				return INVALID_BLOCK;
+			}
+			FL = GetLowestSetBit(FLMap);
+			SLMap = SLBitmaps[FL];
+		}
+		return FreeLists[FL][GetLowestSetBit(SLMap)];
+	}
+
+	bool Fits(uint32 Block, uint64 InSize, uint64 Alignment) const
+	{
+		return Align(Blocks[Block].Offset, Alignment) + InSize <= Blocks[Block].Offset + Blocks[Block].Size;
+	}
+
+	// First fit in the list InSize itself belongs to, which FindFree() never looks at for sizes not on a list boundary
+	uint32 FindFreeInList(uint64 InSize, uint64 Alignment) const
+	{
+		uint32 FL, SL;
+		GetLists(InSize, FL, SL);
+		if (FL >= FL_COUNT)
+		{
+			return INVALID_BLOCK;
+		}
+		for (uint32 Block = FreeLists[FL][SL]; Block != INVALID_BLOCK; Block = Blocks[Block].NextFree)
+		{
+			if (Fits(Block, InSize, Alignment))
+			{
+				return Block;
+			}
+		}
+		return INVALID_BLOCK;
+	}
+
+	void InsertFree(uint32 Block)
+	{
+		uint32 FL, SL;
+		GetLists(Blocks[Block].Size, FL, SL);
+		FBlock& Entry = Blocks[Block];
+		Entry.bFree = true;
+		Entry.PrevFree = INVALID_BLOCK;
+		Entry.NextFree = FreeLists[FL][SL];
+		if (Entry.NextFree != INVALID_BLOCK)
+		{
+			Blocks[Entry.NextFree].PrevFree = Block;
+		}
+		FreeLists[FL][SL] = Block;
+		FLBitmap |= (uint64)1 << FL;
+		SLBitmaps[FL] |= 1u << SL;
+	}
+
+	void RemoveFree(uint32 Block)
+	{
+		FBlock& Entry = Blocks[Block];
+		if (Entry.PrevFree != INVALID_BLOCK)
+		{
+			Blocks[Entry.PrevFree].NextFree = Entry.NextFree;
+		}
+		else
+		{
+			uint32 FL, SL;
+			GetLists(Entry.Size, FL, SL);
+			FreeLists[FL][SL] = Entry.NextFree;
+			if (Entry.NextFree == INVALID_BLOCK)
+			{
+				SLBitmaps[FL] &= ~(1u << SL);
+				if (!SLBitmaps[FL])
+				{
+					FLBitmap &= ~((uint64)1 << FL);
+				}
+			}
+		}
+		if (Entry.NextFree != INVALID_BLOCK)
+		{
+			Blocks[Entry.NextFree].PrevFree = Entry.PrevFree;
+		}
+		Entry.bFree = false;
+	}
+
+	uint32 NewBlock(uint64 Offset, uint64 InSize)
+	{
+		uint32 Block = FirstUnusedBlock;
+		if (Block != INVALID_BLOCK)
+		{
+			FirstUnusedBlock = Blocks[Block].NextFree;
+		}
+		else
+		{
+			Block = (uint32)Blocks.size();
+			Blocks.emplace_back();
+		}
+		FBlock& Entry = Blocks[Block];
+		Entry.Offset = Offset;
+		Entry.Size = InSize;
+		Entry.PrevPhysical = INVALID_BLOCK;
+		Entry.NextPhysical = INVALID_BLOCK;
+		Entry.PrevFree = INVALID_BLOCK;
+		Entry.NextFree = INVALID_BLOCK;
+		Entry.bFree = false;
+		return Block;
+	}
+
+	// Cuts Block to InSize and returns a new block with the rest
+	uint32 Split(uint32 Block, uint64 InSize)
+	{
+		check(Blocks[Block].Size > InSize);
+		const uint32 Rest = NewBlock(Blocks[Block].Offset + InSize, Blocks[Block].Size - InSize);
+		FBlock& Entry = Blocks[Block];
+		Entry.Size = InSize;
+		Blocks[Rest].PrevPhysical = Block;
+		Blocks[Rest].NextPhysical = Entry.NextPhysical;
+		if (Entry.NextPhysical != INVALID_BLOCK)
+		{
+			Blocks[Entry.NextPhysical].PrevPhysical = Rest;
+		}
+		Entry.NextPhysical = Rest;
+		return Rest;
+	}
+
+	// Grows Block over Next, which goes back to the unused entries
+	void Merge(uint32 Block, uint32 Next)
+	{
+		FBlock& Entry = Blocks[Block];
+		check(Entry.NextPhysical == Next);
+		Entry.Size += Blocks[Next].Size;
+		Entry.NextPhysical = Blocks[Next].NextPhysical;
+		if (Entry.NextPhysical != INVALID_BLOCK)
+		{
+			Blocks[Entry.NextPhysical].PrevPhysical = Block;
+		}
+		Blocks[Next].NextFree = FirstUnusedBlock;
+		FirstUnusedBlock = Next;
+	}
+};
+
+struct FHeapSuballocation
+{
+	uint32 Page = (uint32)-1;
+	uint32 Block = FTLSFAllocator::INVALID_BLOCK;
+	uint64 Offset = 0;
+	uint64 Size = 0;
+
+	bool IsValid() const
+	{
+		return Page != (uint32)-1;
+	}
+};
+
+// Splits fixed size pages into suballocations. Every page belongs to one pool chosen by the caller (eg heap type and
+// resource class), and suballocations only come from pages in the same pool. The caller owns the actual memory for
+// each page index; Alloc() says when a new page was added so it can create it.
+class FHeapSuballocator
+{
+public:
+	void Create(uint64 InPageSize)
+	{
+		check(Pages.empty());
+		PageSize = InPageSize;
+	}
+
+	void Destroy()
+	{
+		Pages.clear();
+		PoolPages.clear();
+	}
+
+	// Anything larger wastes too much of a page and is better off with its own memory
+	bool CanSuballocate(uint64 Size, uint64 Alignment) const
+	{
+		return Size <= PageSize / 2 && Alignment <= PageSize;
+	}
+
+	FHeapSuballocation Alloc(uint32 Pool, uint64 Size, uint64 Alignment, bool& bOutNewPage)
+	{
+		check(CanSuballocate(Size, Alignment));
+		FHeapSuballocation Suballocation;
+		Suballocation.Size = Size;
+		bOutNewPage = false;
+
+		auto& Indices = PoolPages[Pool];
+		for (uint32 Index : Indices)
+		{
+			Suballocation.Block = Pages[Index].Ranges.Alloc(Size, Alignment, Suballocation.Offset);
+			if (Suballocation.Block != FTLSFAllocator::INVALID_BLOCK)
+			{
+				Suballocation.Page = Index;
+				return Suballocation;
+			}
+		}
+
+		FPage NewPage;
+		NewPage.Pool = Pool;
+		NewPage.Ranges.Create(PageSize);
+		Suballocation.Page = (uint32)Pages.size();
+		Pages.push_back(NewPage);
+		Indices.push_back(Suballocation.Page);
+		bOutNewPage = true;
+
+		Suballocation.Block = Pages[Suballocation.Page].Ranges.Alloc(Size, Alignment, Suballocation.Offset);
+		check(Suballocation.Block != FTLSFAllocator::INVALID_BLOCK);
+		return Suballocation;
+	}
+
+	void Free(const FHeapSuballocation& Suballocation)
+	{
+		check(Suballocation.IsValid() && Suballocation.Page < (uint32)Pages.size());
+		Pages[Suballocation.Page].Ranges.Free(Suballocation.Block);
+	}
+
+	uint64 GetPageSize() const
+	{
+		return PageSize;
+	}
+
+	uint32 GetNumPages() const
+	{
+		return (uint32)Pages.size();
+	}
+
+	uint32 GetPagePool(uint32 Page) const
+	{
+		return Pages[Page].Pool;
+	}
+
+	const FTLSFAllocator& GetPageRanges(uint32 Page) const
+	{
+		return Pages[Page].Ranges;
+	}
+
+protected:
+	struct FPage
+	{
+		uint32 Pool = 0;
+		FTLSFAllocator Ranges;
+	};
+
+	uint64 PageSize = 0;
+	std::vector<FPage> Pages;
+
+	// Pool -> indices into Pages, in creation order
+	std::map<uint32, std::vector<uint32>> PoolPages;
+};
+
+// Bump allocates from a ring of Size bytes. Allocations made before EndFrame() belong to that frame and are only reused
+// once Retire() is given a completed fence value at least as large as the one EndFrame() was called with.
+class FRingAllocator
+{
+public:
+	// InSize has to be a power of two, as Alloc() wraps with Align()
+	void Create(uint64 InSize)
+	{
+		check(IsPowerOfTwo(InSize));
+		Size = InSize;
+		Head = 0;
+		Tail = 0;
+		Frames.clear();
+	}
+
+	// Returns false if the space is still in use by frames in flight
+	bool Alloc(uint64 InSize, uint64 Alignment, uint64& OutOffset)
+	{
+		check(InSize > 0 && Size % Alignment == 0);
+
+		// Head and Tail only grow, so Size being a multiple of Alignment keeps the offsets in the ring aligned too
+		uint64 Begin = Align(Head, Alignment);
+		if (Begin % Size + InSize > Size)
+		{
+			// Not enough room before the end; skip to the start of the ring
+			Begin = Align(Begin, Size);
+		}
+		if (Begin + InSize - Tail > Size)
+		{
+			return false;
+		}
+
+		Head = Begin + InSize;
+		OutOffset = Begin % Size;
+		return true;
+	}
+
+	// Everything allocated since the last EndFrame() is in use until FenceValue completes. FenceValue must increase
+	// every frame.
+	void EndFrame(uint64 FenceValue)
+	{
+		check(Frames.empty() || Frames.back().FenceValue < FenceValue);
+		FFrame Frame;
+		Frame.FenceValue = FenceValue;
+		Frame.End = Head;
+		Frames.push_back(Frame);
+	}
+
+	void Retire(uint64 CompletedFenceValue)
+	{
+		while (!Frames.empty() && Frames.front().FenceValue <= CompletedFenceValue)
+		{
+			Tail = Frames.front().End;
+			Frames.pop_front();
+		}
+	}
+
+	uint64 GetSize() const
+	{
+		return Size;
+	}
+
+	// Includes the current frame and whatever was skipped at the end of the ring
+	uint64 GetUsed() const
+	{
+		return Head - Tail;
+	}
+
+	uint32 GetNumFramesInFlight() const
+	{
+		return (uint32)Frames.size();
+	}
+
+protected:
+	struct FFrame
+	{
+		uint64 FenceValue;
+		uint64 End;
+	};
+
+	uint64 Size = 0;
+
+	// Positions as if the ring never wrapped; the offset in the ring is modulo Size
+	uint64 Head = 0;
+	uint64 Tail = 0;
+
+	std::deque<FFrame> Frames;
+};
+
+enum class EMemCategory : uint32
+{
+	// Default heap buffers
+	Buffer,
+
+	// Textures that aren't render or depth targets
+	Texture,
+	RenderTarget,
+
+	// Upload heap buffers
+	Upload,
+
+	Num
+};
+
+inline const char* GetMemCategoryName(EMemCategory Category)
+{
+	switch (Category)
+	{
+	case EMemCategory::Buffer:
+		return "Buffer";
+	case EMemCategory::Texture:
+		return "Texture";
+	case EMemCategory::RenderTarget:
+		return "RenderTarget";
+	case EMemCategory::Upload:
+		return "Upload";
+	default:
+		check(0);
+		return "";
+	}
+}
+
+struct FMemCounter
+{
+	uint64 Bytes = 0;
+	uint64 PeakBytes = 0;
+	uint32 Count = 0;
+	uint32 PeakCount = 0;
+
+	void Add(uint64 Size)
+	{
+		Bytes += Size;
+		++Count;
+		PeakBytes = Bytes > PeakBytes ? Bytes : PeakBytes;
+		PeakCount = Count > PeakCount ? Count : PeakCount;
+	}
+
+	void Remove(uint64 Size)
+	{
+		check(Bytes >= Size && Count > 0);
+		Bytes -= Size;
+		--Count;
+	}
+};
+
+// Current and peak bytes/counts of live allocations, in total, by category and by name. Not thread safe, same as the
+// allocators feeding it.
+class FMemStats
+{
+public:
+	typedef void (*FBudgetFunction)(uint64 Bytes, uint64 BudgetBytes, void* UserData);
+
+	// Function is called when the total goes over BudgetBytes, and again only after going back under it first.
+	// 0 disables it.
+	void SetBudget(uint64 InBudgetBytes, FBudgetFunction Function, void* InUserData)
+	{
+		BudgetBytes = InBudgetBytes;
+		BudgetFunction = Function;
+		UserData = InUserData;
+		bOverBudget = false;
+		CheckBudget();
+	}
+
+	// Returns the name index to pass to OnFree()
+	uint32 OnAlloc(EMemCategory Category, const char* Name, uint64 Size)
+	{
+		auto Found = NameIndices.find(Name);
+		uint32 NameIndex;
+		if (Found == NameIndices.end())
+		{
+			NameIndex = (uint32)Names.size();
+			NameIndices[Name] = NameIndex;
+			Names.push_back(Name);
+			ByName.emplace_back();
+		}
+		else
+		{
+			NameIndex = Found->second;
+		}
+
+		Total.Add(Size);
+		ByCategory[(uint32)Category].Add(Size);
+		ByName[NameIndex].Add(Size);
+		CheckBudget();
+		return NameIndex;
+	}
+
+	void OnFree(EMemCategory Category, uint32 NameIndex, uint64 Size)
+	{
+		Total.Remove(Size);
+		ByCategory[(uint32)Category].Remove(Size);
+		ByName[NameIndex].Remove(Size);
+		CheckBudget();
+	}
+
+	// Memory reserved for suballocation, which the allocations above are carved from
+	void OnHeapCreated(uint64 Size)
+	{
+		Heaps.Add(Size);
+	}
+
+	void OnHeapDestroyed(uint64 Size)
+	{
+		Heaps.Remove(Size);
+	}
+
+	const FMemCounter& GetTotal() const
+	{
+		return Total;
+	}
+
+	const FMemCounter& GetCategory(EMemCategory Category) const
+	{
+		return ByCategory[(uint32)Category];
+	}
+
+	const FMemCounter& GetHeaps() const
+	{
+		return Heaps;
+	}
+
+	// Zero if nothing by that name was ever allocated
+	FMemCounter GetByName(const char* Name) const
+	{
+		auto Found = NameIndices.find(Name);
+		return Found == NameIndices.end() ? FMemCounter() : ByName[Found->second];
+	}
+
+	std::string ToJson() const
+	{
+		std::string Json = "{\n";
+		Json += "\t\"budget\": " + std::to_string(BudgetBytes) + ",\n";
+		Json += "\t\"total\": " + CounterToJson(Total) + ",\n";
+		Json += "\t\"heaps\": " + CounterToJson(Heaps) + ",\n";
+		Json += "\t\"categories\": {\n";
+		for (uint32 Index = 0; Index < (uint32)EMemCategory::Num; ++Index)
+		{
+			Json += "\t\t\"" + std::string(GetMemCategoryName((EMemCategory)Index)) + "\": " + CounterToJson(ByCategory[Index]);
+			Json += Index + 1 < (uint32)EMemCategory::Num ? ",\n" : "\n";
+		}
+		Json += "\t},\n";
+		Json += "\t\"names\": {\n";
+		for (uint32 Index = 0; Index < (uint32)Names.size(); ++Index)
+		{
+			Json += "\t\t\"" + EscapeJson(Names[Index]) + "\": " + CounterToJson(ByName[Index]);
+			Json += Index + 1 < (uint32)Names.size() ? ",\n" : "\n";
+		}
+		Json += "\t}\n";
+		Json += "}\n";
+		return Json;
+	}
+
+	bool WriteJson(const char* Filename) const
+	{
+		FILE* File = nullptr;
+		fopen_s(&File, Filename, "wb");
+		if (!File)
+		{
+			return false;
+		}
+		const std::string Json = ToJson();
+		const bool bWritten = fwrite(Json.data(), 1, Json.size(), File) == Json.size();
+		fclose(File);
+		return bWritten;
+	}
+
+protected:
+	FMemCounter Total;
+	FMemCounter ByCategory[(uint32)EMemCategory::Num];
+	FMemCounter Heaps;
+
+	std::vector<std::string> Names;
+	std::vector<FMemCounter> ByName;
+	std::map<std::string, uint32> NameIndices;
+
+	uint64 BudgetBytes = 0;
+	FBudgetFunction BudgetFunction = nullptr;
+	void* UserData = nullptr;
+	bool bOverBudget = false;
+
+	void CheckBudget()
+	{
+		if (!BudgetBytes || !BudgetFunction)
+		{
+			return;
+		}
+		if (Total.Bytes > BudgetBytes && !bOverBudget)
+		{
+			bOverBudget = true;
+			BudgetFunction(Total.Bytes, BudgetBytes, UserData);
+		}
+		else if (Total.Bytes <= BudgetBytes)
+		{
+			bOverBudget = false;
+		}
+	}
+
+	static std::string CounterToJson(const FMemCounter& Counter)
+	{
+		char s[256];
+		sprintf_s(s, sizeof(s), "{\"bytes\": %llu, \"peakBytes\": %llu, \"count\": %u, \"peakCount\": %u}",
+			(unsigned long long)Counter.Bytes, (unsigned long long)Counter.PeakBytes, Counter.Count, Counter.PeakCount);
+		return s;
+	}
+
+	static std::string EscapeJson(const std::string& String)
+	{
+		std::string Escaped;
+		for (char c : String)
+		{
+			if (c == '"' || c == '\\')
+			{
+				Escaped += '\\';
+				Escaped += c;
+			}
+			else if ((unsigned char)c < 0x20)
+			{
+				char s[8];
+				sprintf_s(s, sizeof(s), "\\u%04x", (unsigned)c);
+				Escaped += s;
+			}
+			else
+			{
+				Escaped += c;
+			}
+		}
+		return Escaped;
+	}
+};
+
+// Things released while the GPU may still be using them. Each one waits until the fence value it was released with
+// completes, then goes into a pool under its key so the next allocation with the same key can have it back; pooled
+// ones nobody asked for in MaxPoolAge fence values are handed to the caller to destroy. TKey needs operator<.
+template <typename TKey, typename TItem>
+class FRecycler
+{
+public:
+	// FenceValue is the one that will be signaled after the GPU's last use of Item; it can't go down between calls
+	void Release(const TKey& Key, TItem Item, uint64 FenceValue)
+	{
+		check(Pending.empty() || Pending.back().FenceValue <= FenceValue);
+		FEntry Entry;
+		Entry.Key = Key;
+		Entry.Item = Item;
+		Entry.FenceValue = FenceValue;
+		Entry.bAcquired = false;
+		Pending.push_back(Entry);
+	}
+
+	// Returns false if nothing with Key is ready for reuse; otherwise hands out the oldest one
+	bool Acquire(const TKey& Key, TItem& OutItem)
+	{
+		auto Found = Pool.lower_bound(Key);
+		if (Found == Pool.end() || Key < Found->first)
+		{
+			return false;
+		}
+		FEntry& Entry = Pooled[(size_t)(Found->second - NumRetired)];
+		Entry.bAcquired = true;
+		OutItem = Entry.Item;
+		Pool.erase(Found);
+		return true;
+	}
+
+	// Pools everything whose fence completed, and passes pooled items unused for more than MaxPoolAge fence values
+	// to DestroyLambda. Pooled is in fence order, so only its front can be old enough.
+	template <typename TDestroyLambda>
+	void Process(uint64 CompletedFenceValue, uint64 MaxPoolAge, TDestroyLambda DestroyLambda)
+	{
+		while (!Pending.empty() && Pending.front().FenceValue <= CompletedFenceValue)
+		{
+			// Equal keys keep their insertion order, so each key's oldest entry is its lower_bound()
+			Pool.insert(std::make_pair(Pending.front().Key, NumRetired + Pooled.size()));
+			Pooled.push_back(Pending.front());
+			Pending.pop_front();
+		}
+
+		while (!Pooled.empty() && (Pooled.front().bAcquired || Pooled.front().FenceValue + MaxPoolAge < CompletedFenceValue))
+		{
+			FEntry& Entry = Pooled.front();
+			if (!Entry.bAcquired)
+			{
+				auto Found = Pool.lower_bound(Entry.Key);
+				check(Found != Pool.end() && Found->second == NumRetired);
+				Pool.erase(Found);
+				DestroyLambda(Entry.Item);
+			}
+			Pooled.pop_front();
+			++NumRetired;
+		}
+	}
+
+	// Forgets everything, pending or pooled, without destroying it
+	void Clear()
+	{
+		Pending.clear();
+		Pooled.clear();
+		Pool.clear();
+		NumRetired = 0;
+	}
+
+	uint32 GetNumPending() const
+	{
+		return (uint32)Pending.size();
+	}
+
+	uint32 GetNumPooled() const
+	{
+		return (uint32)Pool.size();
+	}
+
+protected:
+	struct FEntry
+	{
+		TKey Key;
+		TItem Item;
+		uint64 FenceValue;
+		bool bAcquired;
+	};
+
+	std::deque<FEntry> Pending;
+
+	// Pooled entries in the order they were released; acquired ones stay until they reach the front. Pool maps keys to
+	// the ones still available, numbered from the first ever pooled, and NumRetired is the number of Pooled.front().
+	std::deque<FEntry> Pooled;
+	std::multimap<TKey, uint64> Pool;
+	uint64 NumRetired = 0;
+};
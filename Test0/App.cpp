@@ -34,11 +34,30 @@ static FDevice GDevice;
 static FSwapchain GSwapchain;
 static FCmdBufferMgr GCmdBufferMgr;
 static FMemManager GMemMgr;
+
+// -memstats=<file> writes GMemMgr.Stats as JSON on exit, with the peaks for the whole run
+static std::string GMemStatsFilename;
 static FDescriptorPool GDescriptorPool;
 static FStagingManager GStagingManager;
 
 static FVertexBuffer GObjVB;
+static FIndexBuffer GObjIB;
 static Obj::FObj GObj;
+static FIndexedMesh GObjMesh;
+static uint32 GObjNumVertices = 0;
+static uint32 GObjNumIndices = 0;
+static std::vector<FMeshSection> GObjSections;
+
+enum class EObjVertexFormat
+{
+	Float,					// FPosColorUVVertex, 24 bytes
+	Quantized,				// FQuantizedVertex, 12 bytes
+	QuantizedTangentFrame,	// FQuantizedTangentVertex, 16 bytes; adds tangents for normal mapping
+};
+static EObjVertexFormat GObjVertexFormat = EObjVertexFormat::Quantized;
+static uint32 GObjVertexStride = 0;
+static FVertexQuantization GObjQuantization = FVertexQuantization::GetIdentity();
+static FMeshBounds GObjBounds;
 static FRWVertexBuffer GFloorVB;
 static FRWIndexBuffer GFloorIB;
 struct FCreateFloorUB
@@ -49,20 +68,46 @@ struct FCreateFloorUB
 	uint32 NumQuadsZ;
 	float Elevation;
 };
-static FUniformBuffer<FCreateFloorUB> GCreateFloorUB;
+static FCreateFloorUB GCreateFloor;
+
+// World space bounds of the draws, tested against the view frustum every frame
+static FCullBounds GDrawBounds;
+static uint32 GFloorBoundsIndex = 0;
+static uint32 GObjBoundsIndex = 0;
+static bool GbFloorVisible = true;
+static bool GbObjVisible = true;
 struct FViewUB
 {
 	FMatrix4x4 View;
 	FMatrix4x4 Proj;
 };
-static FUniformBuffer<FViewUB> GViewUB;
+static FViewUB GView;
 struct FObjUB
 {
 	FMatrix4x4 Obj;
+
+	// Matches the cbuffer packing in TestVS.hlsl
+	FVector3 PosScale;
+	uint32 NormalEncoding;
+	FVector3 PosBias;
+	float Padding;
+
+	void SetVertexFormat(const FVertexQuantization& Quantization, EObjVertexFormat Format)
+	{
+		PosScale = Quantization.Scale;
+		PosBias = Quantization.Bias;
+		NormalEncoding = (uint32)Format;
+	}
 };
-static FUniformBuffer<FObjUB> GObjUB;
+static FObjUB GObjConstants;
 static FUniformBuffer<FObjUB> GIdentityUB;
 
+// GView, GObjConstants and GCreateFloor are copied in every frame; the addresses are for this frame's copies
+static FFrameFence GFrameFence;
+static FUploadRing GUploadRing;
+static D3D12_GPU_VIRTUAL_ADDRESS GViewUBAddress = 0;
+static D3D12_GPU_VIRTUAL_ADDRESS GObjUBAddress = 0;
+
 static FImage2DWithView GCheckerboardTexture;
 static FImage2DWithView GHeightMap;
 static FSampler GSampler;
@@ -141,13 +186,12 @@ struct FRenderTargetPool
 #endif
 		//Entry->Name = InName;
 
-		Entry->Texture.Create(*Device, Width, Height, Format, GDescriptorPool, MemMgr,
+		Entry->Texture.Create(InName, *Device, Width, Height, Format, GDescriptorPool, MemMgr,
 			(IsDepthOrStencilFormat(Format) ? (D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL) : (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS))
 #if ENABLE_VULKAN
 			NumMips, Samples
 #endif
 		);
-		Entry->Texture.Image.Alloc->Resource->SetName(InName);
 
 		return Entry;
 	}
@@ -206,6 +250,8 @@ struct FPosColorUVVertex
 	float u, v;
 };
 FVertexFormat GPosColorUVFormat;
+FVertexFormat GQuantizedFormat;
+FVertexFormat GQuantizedTangentFormat;
 
 bool GQuitting = false;
 
@@ -491,43 +537,182 @@ static bool LoadShadersAndGeometry()
 	GPosColorUVFormat.AddVertexAttribute("COLOR", 0, 1, DXGI_FORMAT_R8G8B8A8_UNORM, offsetof(FPosColorUVVertex, Color));
 	GPosColorUVFormat.AddVertexAttribute("TEXCOORD", 0, 2, DXGI_FORMAT_R32G32_FLOAT, offsetof(FPosColorUVVertex, u));
 
+	// Position's w overlaps the normal and is ignored by the shader
+	GQuantizedFormat.AddVertexBuffer(0, sizeof(FQuantizedVertex), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA);
+	GQuantizedFormat.AddVertexAttribute("POSITION", 0, 0, DXGI_FORMAT_R16G16B16A16_UNORM, offsetof(FQuantizedVertex, Pos));
+	GQuantizedFormat.AddVertexAttribute("COLOR", 0, 1, DXGI_FORMAT_R8G8_SNORM, offsetof(FQuantizedVertex, Normal));
+	GQuantizedFormat.AddVertexAttribute("TEXCOORD", 0, 2, DXGI_FORMAT_R16G16_FLOAT, offsetof(FQuantizedVertex, UV));
+
+	GQuantizedTangentFormat.AddVertexBuffer(0, sizeof(FQuantizedTangentVertex), D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA);
+	GQuantizedTangentFormat.AddVertexAttribute("POSITION", 0, 0, DXGI_FORMAT_R16G16B16A16_UNORM, offsetof(FQuantizedTangentVertex, Pos));
+	GQuantizedTangentFormat.AddVertexAttribute("COLOR", 0, 1, DXGI_FORMAT_R8G8B8A8_SNORM, offsetof(FQuantizedTangentVertex, TangentFrame));
+	GQuantizedTangentFormat.AddVertexAttribute("TEXCOORD", 0, 2, DXGI_FORMAT_R16G16_FLOAT, offsetof(FQuantizedTangentVertex, UV));
+
 	// Load and fill geometry
-	if (!Obj::Load("../Meshes/Cube/cube.obj", GObj))
+	const char* ObjFilename = "../Meshes/Cube/cube.obj";
+	Obj::FCachedMesh CachedMesh;
+	std::vector<char> Vertices;
+	std::vector<char> Indices;
+	const void* VertexData = nullptr;
+	const void* IndexData = nullptr;
+	bool b32BitIndices = false;
+	GObjVertexStride = GObjVertexFormat == EObjVertexFormat::QuantizedTangentFrame ? sizeof(FQuantizedTangentVertex) :
+		(GObjVertexFormat == EObjVertexFormat::Quantized ? sizeof(FQuantizedVertex) : sizeof(FPosColorUVVertex));
+	if (Obj::LoadCache(ObjFilename, GObjVertexStride, CachedMesh) && CachedMesh.NumIndices > 0)
 	{
-		return false;
+		GObjNumVertices = CachedMesh.NumVertices;
+		GObjNumIndices = CachedMesh.NumIndices;
+		VertexData = CachedMesh.Vertices;
+		IndexData = CachedMesh.Indices;
+		b32BitIndices = CachedMesh.IndexStride == 4;
+		GObjSections.assign(CachedMesh.Sections, CachedMesh.Sections + CachedMesh.NumSections);
+		GObjQuantization = CachedMesh.Quantization;
+		GObjBounds = CachedMesh.Bounds;
 	}
+	else
+	{
+		if (!Obj::Load(ObjFilename, GObj))
+		{
+			return false;
+		}
 
-	GObjVB.Create(L"ObjVB", GDevice, sizeof(FPosColorUVVertex), sizeof(FPosColorUVVertex) * (uint32)GObj.Faces.size() * 3, GMemMgr, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, true);
-	//GObj.Faces.resize(1);
+		// Faces without vn get smooth normals, split where faces meet at more than 45 degrees
+		uint32 NumMissingNormals = 0;
+		for (auto& Face : GObj.Faces)
+		{
+			for (auto& Corner : Face.Corners)
+			{
+				NumMissingNormals += Corner.Normal == -1 ? 1 : 0;
+			}
+		}
+		if (NumMissingNormals > 0)
+		{
+			double StartTime = GetTimeInMs();
+			Obj::GenerateNormals(GObj, 45.0f);
+			char s[256];
+			sprintf_s(s, sizeof(s), "*** %s: normals for %u corners in %.2f ms\n", ObjFilename, NumMissingNormals, GetTimeInMs() - StartTime);
+			::OutputDebugStringA(s);
+		}
 
-	auto FillObj = [](void* Data)
-	{
-		check(Data);
-		auto* Vertex = (FPosColorUVVertex*)Data;
-		for (uint32 Index = 0; Index < GObj.Faces.size(); ++Index)
+		//GObj.Faces.resize(1);
+		Obj::BuildIndexedMesh(GObj, GObjMesh);
 		{
-			auto& Face = GObj.Faces[Index];
-			for (uint32 Corner = 0; Corner < 3; ++Corner)
+			const float LodRatios[] = {0.5f, 0.25f, 0.125f};
+			BuildLodChain(GObjMesh, LodRatios, _countof(LodRatios));
+			for (auto& Section : GObjMesh.Sections)
 			{
-				Vertex->x = GObj.Vs[Face.Corners[Corner].Pos].x;
-				Vertex->y = GObj.Vs[Face.Corners[Corner].Pos].y;
-				Vertex->z = GObj.Vs[Face.Corners[Corner].Pos].z;
-				Vertex->Color = PackNormalToU32(GObj.VNs[Face.Corners[Corner].Normal]);
-				Vertex->u = GObj.VTs[Face.Corners[Corner].UV].u;
-				Vertex->v = GObj.VTs[Face.Corners[Corner].UV].v;
-				++Vertex;
+				char s[256];
+				sprintf_s(s, sizeof(s), "*** %s: LOD %u material %u: %u triangles, error %f\n", ObjFilename, Section.Lod, Section.Material, Section.NumIndices / 3, Section.LodError);
+				::OutputDebugStringA(s);
 			}
 		}
+		{
+			FVertexCacheStats Before = AnalyzeVertexCache(GObjMesh);
+			OptimizeVertexCache(GObjMesh);
+			OptimizeVertexFetch(GObjMesh);
+			FVertexCacheStats After = AnalyzeVertexCache(GObjMesh);
+			char s[256];
+			sprintf_s(s, sizeof(s), "*** %s: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f\n", ObjFilename, Before.ACMR, After.ACMR, Before.ATVR, After.ATVR);
+			::OutputDebugStringA(s);
+			sprintf_s(s, sizeof(s), "*** %s: %u materials, %u draws\n", ObjFilename, (uint32)GObj.Materials.size(), (uint32)GObjMesh.Sections.size());
+			::OutputDebugStringA(s);
+		}
+
+		if (GObjVertexFormat == EObjVertexFormat::QuantizedTangentFrame)
+		{
+			double StartTime = GetTimeInMs();
+			ComputeTangents(GObjMesh);
+			char s[256];
+			sprintf_s(s, sizeof(s), "*** %s: tangents for %u triangles in %.2f ms\n", ObjFilename, GObjMesh.GetNumTriangles(), GetTimeInMs() - StartTime);
+			::OutputDebugStringA(s);
+		}
+
+		GObjBounds = ComputeMeshBounds(GObjMesh.Vertices.data(), (uint32)GObjMesh.Vertices.size());
+		Vertices.resize(GObjMesh.Vertices.size() * GObjVertexStride);
+		if (GObjVertexFormat == EObjVertexFormat::QuantizedTangentFrame)
+		{
+			GObjQuantization = ComputeVertexQuantization(GObjMesh.Vertices.data(), (uint32)GObjMesh.Vertices.size());
+			QuantizeVertices(GObjMesh, GObjQuantization, (FQuantizedTangentVertex*)Vertices.data());
+		}
+		else if (GObjVertexFormat == EObjVertexFormat::Quantized)
+		{
+			GObjQuantization = ComputeVertexQuantization(GObjMesh.Vertices.data(), (uint32)GObjMesh.Vertices.size());
+			QuantizeVertices(GObjMesh.Vertices.data(), (uint32)GObjMesh.Vertices.size(), GObjQuantization, (FQuantizedVertex*)Vertices.data());
+		}
+		else
+		{
+			for (uint32 Index = 0; Index < (uint32)GObjMesh.Vertices.size(); ++Index)
+			{
+				const FMeshVertex& In = GObjMesh.Vertices[Index];
+				FPosColorUVVertex& Vertex = ((FPosColorUVVertex*)Vertices.data())[Index];
+				Vertex.x = In.Pos.x;
+				Vertex.y = In.Pos.y;
+				Vertex.z = In.Pos.z;
+				Vertex.u = In.UV.u;
+				Vertex.v = In.UV.v;
+			}
+			PackNormalsToU32(&GObjMesh.Vertices[0].Normal, sizeof(FMeshVertex), (uint32)GObjMesh.Vertices.size(), &((FPosColorUVVertex*)Vertices.data())->Color, sizeof(FPosColorUVVertex));
+		}
+
+		b32BitIndices = GObjMesh.Needs32BitIndices();
+		const uint32 IndexStride = b32BitIndices ? 4 : 2;
+		Indices.resize(GObjMesh.Indices.size() * IndexStride);
+		for (uint32 Index = 0; Index < (uint32)GObjMesh.Indices.size(); ++Index)
+		{
+			if (b32BitIndices)
+			{
+				((uint32*)Indices.data())[Index] = GObjMesh.Indices[Index];
+			}
+			else
+			{
+				((uint16*)Indices.data())[Index] = (uint16)GObjMesh.Indices[Index];
+			}
+		}
+
+		GObjNumVertices = (uint32)GObjMesh.Vertices.size();
+		GObjNumIndices = (uint32)GObjMesh.Indices.size();
+		VertexData = Vertices.data();
+		IndexData = Indices.data();
+		GObjSections = GObjMesh.Sections;
+		Obj::SaveCache(ObjFilename, VertexData, GObjVertexStride, GObjNumVertices, IndexData, IndexStride, GObjNumIndices, GObjSections.data(), (uint32)GObjSections.size(), GObjBounds, GObjQuantization);
+
+		{
+			const uint32 NumCorners = (uint32)GObj.Faces.size() * 3;
+			char s[256];
+			sprintf_s(s, sizeof(s), "*** %s: %u corners -> %u vertices, %u KB -> %u KB (%d bit indices, %u KB of vertices at %u bytes instead of %u KB)\n", ObjFilename,
+				NumCorners, GObjNumVertices, NumCorners * (uint32)sizeof(FPosColorUVVertex) / 1024,
+				(GObjNumVertices * GObjVertexStride + GObjNumIndices * IndexStride) / 1024, IndexStride * 8,
+				GObjNumVertices * GObjVertexStride / 1024, GObjVertexStride, GObjNumVertices * (uint32)sizeof(FPosColorUVVertex) / 1024);
+			::OutputDebugStringA(s);
+		}
+	}
+
+	GObjVB.Create(L"ObjVB", GDevice, GObjVertexStride, GObjVertexStride * GObjNumVertices, GMemMgr, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, true);
+	GObjIB.Create(L"ObjIB", GDevice, b32BitIndices, GObjNumIndices, GMemMgr, D3D12_RESOURCE_STATE_INDEX_BUFFER, true);
+
+	auto FillObj = [&](void* Data)
+	{
+		check(Data);
+		memcpy(Data, VertexData, GObjVertexStride * GObjNumVertices);
 	};
-	MapAndFillBufferSyncOneShotCmdBuffer(GDevice, &GObjVB.Buffer, FillObj, sizeof(FPosColorUVVertex) * (uint32)GObj.Faces.size() * 3);
+	MapAndFillBufferSyncOneShotCmdBuffer(GDevice, &GObjVB.Buffer, FillObj, GObjVertexStride * GObjNumVertices);
+
+	const uint32 IndicesSize = GObjNumIndices * (b32BitIndices ? 4 : 2);
+	auto FillIndices = [&](void* Data)
+	{
+		check(Data);
+		memcpy(Data, IndexData, IndicesSize);
+	};
+	MapAndFillBufferSyncOneShotCmdBuffer(GDevice, &GObjIB.Buffer, FillIndices, IndicesSize);
+	CachedMesh.Close();
 	return true;
 }
 
 void CreateAndFillTexture()
 {
 	srand(0);
-	GCheckerboardTexture.Create(GDevice, 64, 64, DXGI_FORMAT_R8G8B8A8_UNORM, GDescriptorPool, GMemMgr, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
-	GHeightMap.Create(GDevice, 64, 64, DXGI_FORMAT_R32_FLOAT, GDescriptorPool, GMemMgr);
+	GCheckerboardTexture.Create(L"Checkerboard", GDevice, 64, 64, DXGI_FORMAT_R8G8B8A8_UNORM, GDescriptorPool, GMemMgr, D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+	GHeightMap.Create(L"HeightMap", GDevice, 64, 64, DXGI_FORMAT_R32_FLOAT, GDescriptorPool, GMemMgr);
 
 	auto* CmdBuffer = GCmdBufferMgr.AllocateCmdBuffer(GDevice);
 	CmdBuffer->Begin();
@@ -581,12 +766,12 @@ static void FillFloor(FCmdBuffer* CmdBuffer)
 	ResourceBarrier(CmdBuffer, GFloorIB.IB.Buffer.Alloc->Resource.Get(), D3D12_RESOURCE_STATE_INDEX_BUFFER, D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
 	auto* ComputePipeline = GObjectCache.GetOrCreateComputePipeline(&GSetupFloorPSO);
 	CmdBuffer->CommandList->SetPipelineState(ComputePipeline->PipelineState.Get());
-	FCreateFloorUB& CreateFloorUB = *GCreateFloorUB.GetMappedData();
+	const FCreateFloorUB& CreateFloorUB = GCreateFloor;
 	CmdBuffer->CommandList->SetComputeRootSignature(GSetupFloorPSO.RootSignature.Get());
 
 	ID3D12DescriptorHeap* ppHeaps[] = {GDescriptorPool.CSUHeap.Get(), GDescriptorPool.SamplerHeap.Get()};
 	CmdBuffer->CommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-	CmdBuffer->CommandList->SetComputeRootConstantBufferView(0, GCreateFloorUB.View.BufferLocation);
+	CmdBuffer->CommandList->SetComputeRootConstantBufferView(0, GUploadRing.Alloc(CreateFloorUB));
 	FDescriptorHandle IBHandle = GDescriptorPool.AllocateCSU();
 	FDescriptorHandle VBHandle = GDescriptorPool.AllocateCSU();
 	FDescriptorHandle HeightmapHandle = GDescriptorPool.AllocateCSU();
@@ -632,14 +817,19 @@ static void SetupFloor()
 	uint32 NumQuadsX = 128;
 	uint32 NumQuadsZ = 128;
 	float Elevation = 40;
-	GCreateFloorUB.Create(GDevice, GDescriptorPool, GMemMgr, true);
 	{
-		FCreateFloorUB& CreateFloorUB = *GCreateFloorUB.GetMappedData();
+		FCreateFloorUB& CreateFloorUB = GCreateFloor;
 		CreateFloorUB.Y = 10;
 		CreateFloorUB.Extent = 250;
 		CreateFloorUB.NumQuadsX = NumQuadsX;
 		CreateFloorUB.NumQuadsZ = NumQuadsZ;
 		CreateFloorUB.Elevation = Elevation;
+
+		// The heightmap is in 0..1
+		FBox Bounds;
+		Bounds.Min = {{{-CreateFloorUB.Extent, CreateFloorUB.Y, -CreateFloorUB.Extent}}};
+		Bounds.Max = {{{CreateFloorUB.Extent, CreateFloorUB.Y + Elevation, CreateFloorUB.Extent}}};
+		GFloorBoundsIndex = GDrawBounds.Add(Bounds);
 	}
 	GFloorVB.Create(GDevice, GDescriptorPool, sizeof(FPosColorUVVertex), sizeof(FPosColorUVVertex) * 4 * NumQuadsX * NumQuadsZ, GMemMgr, false);
 	GFloorIB.Create(GDevice, GDescriptorPool, true, 3 * 2 * (NumQuadsX - 1) * (NumQuadsZ - 1), GMemMgr, false);
@@ -666,6 +856,7 @@ static void SetupFloor()
 
 bool DoInit(HINSTANCE hInstance, HWND hWnd, uint32& Width, uint32& Height)
 {
+	uint64 MemBudgetMB = 0;
 	LPSTR CmdLine = ::GetCommandLineA();
 	const char* Token = CmdLine;
 	while (Token = strchr(Token, ' '))
@@ -678,12 +869,32 @@ bool DoInit(HINSTANCE hInstance, HWND hWnd, uint32& Width, uint32& Height)
 				Sleep(0);
 			}
 		}
+		else if (!_strnicmp(Token, "-memstats=", 10))
+		{
+			GMemStatsFilename = std::string(Token + 10, strcspn(Token + 10, " "));
+		}
+		else if (!_strnicmp(Token, "-membudget=", 11))
+		{
+			MemBudgetMB = (uint64)_atoi64(Token + 11);
+		}
 	}
 
 	GInstance.Create(hInstance, hWnd);
 	GInstance.CreateDevice(GDevice);
 	GCmdBufferMgr.Create(GDevice/*.Device, GDevice.PresentQueueFamilyIndex*/);
 	GMemMgr.Create(GDevice);
+	if (MemBudgetMB)
+	{
+		auto OnOverBudget = [](uint64 Bytes, uint64 BudgetBytes, void*)
+		{
+			char s[256];
+			sprintf_s(s, sizeof(s), "*** GPU memory over budget: %.1f MB of %.1f MB\n", Bytes / (1024.0 * 1024.0), BudgetBytes / (1024.0 * 1024.0));
+			::OutputDebugStringA(s);
+		};
+		GMemMgr.Stats.SetBudget(MemBudgetMB * 1024 * 1024, OnOverBudget, nullptr);
+	}
+	GFrameFence.Create(GDevice);
+	GUploadRing.Create(GDevice, GMemMgr, GFrameFence, 1024 * 1024);
 	GDescriptorPool.Create(GDevice);
 	GSwapchain.Create(GInstance.DXGIFactory.Get(), hWnd, GDevice, Width, Height, GDescriptorPool);
 
@@ -692,19 +903,19 @@ bool DoInit(HINSTANCE hInstance, HWND hWnd, uint32& Width, uint32& Height)
 	{
 		return false;
 	}
-	GViewUB.Create(GDevice, GDescriptorPool, GMemMgr, true);
-
-	GObjUB.Create(GDevice, GDescriptorPool, GMemMgr, true);
 	GIdentityUB.Create(GDevice, GDescriptorPool, GMemMgr, true);
 
 	{
-		FObjUB& ObjUB = *GObjUB.GetMappedData();
+		FObjUB& ObjUB = GObjConstants;
 		ObjUB.Obj = FMatrix4x4::GetIdentity();
+		ObjUB.SetVertexFormat(GObjQuantization, GObjVertexFormat);
 	}
+	GObjBoundsIndex = GDrawBounds.Add(GObjBounds.Box);
 
 	{
 		FObjUB& ObjUB = *GIdentityUB.GetMappedData();
 		ObjUB.Obj = FMatrix4x4::GetIdentity();
+		ObjUB.SetVertexFormat(FVertexQuantization::GetIdentity(), EObjVertexFormat::Float);
 	}
 
 	GRenderTargetPool.Create();//GDevice.Device, &GMemMgr);
@@ -717,31 +928,38 @@ bool DoInit(HINSTANCE hInstance, HWND hWnd, uint32& Width, uint32& Height)
 #if TRY_MULTITHREADED
 	GThread.Create();
 #endif
+
 	return true;
 }
 
 static void DrawCube(/*FGfxPipeline* GfxPipeline, */FDevice* Device, FCmdBuffer* CmdBuffer)
 {
-	{
-		FObjUB& ObjUB = *GObjUB.GetMappedData();
-		static float AngleDegrees = 0;
-		{
-			AngleDegrees += 360.0f / 10.0f / 60.0f;
-			AngleDegrees = fmod(AngleDegrees, 360.0f);
-		}
-		ObjUB.Obj = FMatrix4x4::GetRotationY(ToRadians(AngleDegrees));
-	}
 	ID3D12DescriptorHeap* ppHeaps[] = {GDescriptorPool.CSUHeap.Get(), GDescriptorPool.SamplerHeap.Get()};
 	CmdBuffer->CommandList->SetGraphicsRootSignature(GTestPSO.RootSignature.Get());
 	CmdBuffer->CommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-	CmdBuffer->CommandList->SetGraphicsRootConstantBufferView(0, GViewUB.View.BufferLocation);
-	CmdBuffer->CommandList->SetGraphicsRootConstantBufferView(1, GObjUB.View.BufferLocation);
+	CmdBuffer->CommandList->SetGraphicsRootConstantBufferView(0, GViewUBAddress);
+	CmdBuffer->CommandList->SetGraphicsRootConstantBufferView(1, GObjUBAddress);
 	CmdBuffer->CommandList->SetGraphicsRootDescriptorTable(2, GHeightMap.ImageView.Handle.GPU);
 	CmdBuffer->CommandList->SetGraphicsRootDescriptorTable(3, GSampler.Handle.GPU);
 
 	CmdBuffer->CommandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 	CmdBind(CmdBuffer, &GObjVB);
-	CmdBuffer->CommandList->DrawInstanced((uint32)GObj.Faces.size() * 3, 1, 0, 0);
+	CmdBind(CmdBuffer, &GObjIB);
+
+	// Coarsest LOD that stays within a pixel at the object's distance
+	const FVector3 CameraPos = {{{GCameraPos.x, GCameraPos.y, GCameraPos.z}}};
+	const float Distance = CameraPos.Length();
+	const float ProjectionScale = (float)GSwapchain.GetHeight() / (2.0f * tan(ToRadians(60) * 0.5f));
+	const uint32 Lod = SelectLod(GObjSections.data(), (uint32)GObjSections.size(), Distance, ProjectionScale, 1.0f);
+
+	// One draw per material
+	for (auto& Section : GObjSections)
+	{
+		if (Section.Lod == Lod)
+		{
+			CmdBuffer->CommandList->DrawIndexedInstanced(Section.NumIndices, 1, Section.FirstIndex, 0, 0);
+		}
+	}
 }
 
 static void DrawFloor(/*FGfxPipeline* GfxPipeline, */FDevice* Device, FCmdBuffer* CmdBuffer)
@@ -749,7 +967,7 @@ static void DrawFloor(/*FGfxPipeline* GfxPipeline, */FDevice* Device, FCmdBuffer
 	ID3D12DescriptorHeap* ppHeaps[] = {GDescriptorPool.CSUHeap.Get(), GDescriptorPool.SamplerHeap.Get()};
 	CmdBuffer->CommandList->SetGraphicsRootSignature(GTestPSO.RootSignature.Get());
 	CmdBuffer->CommandList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
-	CmdBuffer->CommandList->SetGraphicsRootConstantBufferView(0, GViewUB.View.BufferLocation);
+	CmdBuffer->CommandList->SetGraphicsRootConstantBufferView(0, GViewUBAddress);
 	CmdBuffer->CommandList->SetGraphicsRootConstantBufferView(1, GIdentityUB.View.BufferLocation);
 	CmdBuffer->CommandList->SetGraphicsRootDescriptorTable(2, GCheckerboardTexture.ImageView.Handle.GPU);
 	CmdBuffer->CommandList->SetGraphicsRootDescriptorTable(3, GSampler.Handle.GPU);
@@ -778,14 +996,43 @@ static void SetDynamicStates(FCmdBuffer* CmdBuffer, uint32 Width, uint32 Height)
 
 static void UpdateCamera()
 {
-	FViewUB& ViewUB = *GViewUB.GetMappedData();
-	ViewUB.View = FMatrix4x4::GetIdentity();
-	//ViewUB.View.Values[3 * 4 + 2] = -10;
+	FViewUB& ViewUB = GView;
 	GCameraPos = GCameraPos.Add(GControl.StepDirection.Mul3({0.01f, 0.01f, -0.01f}));
 	GRequestControl.StepDirection = {0, 0, 0};
 	GControl.StepDirection ={0, 0, 0};
-	ViewUB.View.Rows[3] = GCameraPos;
+	FTransform View = FTransform::GetIdentity();
+	View.Translation = {{{GCameraPos.x, GCameraPos.y, GCameraPos.z}}};
+	ViewUB.View = View.ToMatrix();
 	ViewUB.Proj = CalculateProjectionMatrix(ToRadians(60), (float)GSwapchain.GetWidth() / (float)GSwapchain.GetHeight(), 0.1f, 1000.0f);
+	GViewUBAddress = GUploadRing.Alloc(ViewUB);
+}
+
+static void UpdateObj()
+{
+	FObjUB& ObjUB = GObjConstants;
+	static float AngleDegrees = 0;
+	{
+		AngleDegrees += 360.0f / 10.0f / 60.0f;
+		AngleDegrees = fmod(AngleDegrees, 360.0f);
+	}
+	FTransform Obj = FTransform::GetIdentity();
+	Obj.Rotation = FQuaternion::FromAxisAngle({{{0, 1, 0}}}, ToRadians(AngleDegrees));
+	const FMatrix4x4 ObjMatrix = Obj.ToMatrix();
+
+	// TestVS reads Obj column major, so mul(Pos, Obj) needs the transpose
+	ObjUB.Obj = ObjMatrix.GetTranspose();
+	GDrawBounds.Set(GObjBoundsIndex, GObjBounds.Box.Transform(ObjMatrix));
+	GObjUBAddress = GUploadRing.Alloc(ObjUB);
+}
+
+static void CullDraws()
+{
+	const FViewUB& ViewUB = GView;
+	const FFrustum Frustum = FFrustum::FromMatrix(ViewUB.View.Mul(ViewUB.Proj));
+	static std::vector<uint32> Visible;
+	CullBoxes(Frustum, GDrawBounds, Visible);
+	GbFloorVisible = std::find(Visible.begin(), Visible.end(), GFloorBoundsIndex) != Visible.end();
+	GbObjVisible = std::find(Visible.begin(), Visible.end(), GObjBoundsIndex) != Visible.end();
 }
 
 static void InternalRenderFrame(FDevice* Device, /*FRenderPass* RenderPass, */FCmdBuffer* CmdBuffer, uint32 Width, uint32 Height)
@@ -795,13 +1042,27 @@ static void InternalRenderFrame(FDevice* Device, /*FRenderPass* RenderPass, */FC
 	CmdBind(CmdBuffer, GfxPipeline);
 
 	SetDynamicStates(CmdBuffer, Width, Height);
-	DrawFloor(/*GfxPipeline, */Device, CmdBuffer);
-	DrawCube(/*GfxPipeline, */Device, CmdBuffer);
+	if (GbFloorVisible)
+	{
+		DrawFloor(/*GfxPipeline, */Device, CmdBuffer);
+	}
+
+	if (GbObjVisible)
+	{
+		if (GObjVertexFormat != EObjVertexFormat::Float)
+		{
+			FVertexFormat* ObjFormat = GObjVertexFormat == EObjVertexFormat::QuantizedTangentFrame ? &GQuantizedTangentFormat : &GQuantizedFormat;
+			CmdBind(CmdBuffer, GObjectCache.GetOrCreateGfxPipeline(&GTestPSO, ObjFormat, GControl.ViewMode == EViewMode::Wireframe));
+		}
+		DrawCube(/*GfxPipeline, */Device, CmdBuffer);
+	}
 }
 
 static void RenderFrame(FDevice* Device, FCmdBuffer* CmdBuffer, FImage2DWithView* ColorBuffer, FImage2DWithView* DepthBuffer/*, FImage2DWithView* ResolveColorBuffer*/)
 {
 	UpdateCamera();
+	UpdateObj();
+	CullDraws();
 
 	FillFloor(CmdBuffer);
 #if ENABLE_VULKAN
@@ -1015,6 +1276,12 @@ void DoRender()
 
 	// First submit needs to wait for present semaphore
 	GCmdBufferMgr.Submit(GDevice, CmdBuffer);//, GDevice.PresentQueue, &GSwapchain.PresentCompleteSemaphores[GSwapchain.PresentCompleteSemaphoreIndex], &GSwapchain.RenderingSemaphores[GSwapchain.AcquiredImageIndex]);
+	{
+		const uint64 SignaledFenceValue = GFrameFence.Signal(GDevice.Queue.Get());
+		const uint64 CompletedFenceValue = GFrameFence.GetCompletedValue();
+		GUploadRing.EndFrame(SignaledFenceValue, CompletedFenceValue);
+		GMemMgr.EndFrame(SignaledFenceValue, CompletedFenceValue);
+	}
 
 	GSwapchain.Present(GDevice.Queue.Get());
 }
@@ -1048,9 +1315,9 @@ void DoDeinit()
 	GQuitting = true;
 	GFloorIB.Destroy();
 	GFloorVB.Destroy();
-	GViewUB.Destroy();
-	GCreateFloorUB.Destroy();
-	GObjUB.Destroy();
+	GUploadRing.Destroy();
+	GFrameFence.Destroy();
+	GObjIB.Destroy();
 	GObjVB.Destroy();
 	GIdentityUB.Destroy();
 	GSampler.Destroy();
@@ -1068,6 +1335,12 @@ void DoDeinit()
 	GStagingManager.Destroy();
 	GRenderTargetPool.Destroy();
 	GObjectCache.Destroy();
+	if (!GMemStatsFilename.empty() && !GMemMgr.Stats.WriteJson(GMemStatsFilename.c_str()))
+	{
+		::OutputDebugStringA("*** Couldn't write ");
+		::OutputDebugStringA(GMemStatsFilename.c_str());
+		::OutputDebugStringA("\n");
+	}
 	GMemMgr.Destroy();
 	GSwapchain.Destroy();
 	GDevice.Destroy();
@@ -0,0 +1,91 @@
+// Types and helpers that don't need windows.h, so code built on them (Allocators.h) compiles on any platform
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+typedef uint8_t uint8;
+typedef int8_t int8;
+typedef uint16_t uint16;
+typedef int16_t int16;
+typedef uint32_t uint32;
+typedef int32_t int32;
+typedef uint64_t uint64;
+typedef int64_t int64;
+
+#if defined(_MSC_VER)
+#define check(x) if (!(x)) __debugbreak();
+#else
+#define check(x) if (!(x)) __builtin_trap();
+
+// The secure CRT functions used by the shared code
+inline int fopen_s(FILE** OutFile, const char* Filename, const char* Mode)
+{
+	*OutFile = fopen(Filename, Mode);
+	return *OutFile ? 0 : 1;
+}
+
+#define sprintf_s snprintf
+#endif
+
+template <typename T>
+inline void MemZero(T& Struct)
+{
+	memset(&Struct, 0, sizeof(T));
+}
+
+inline bool IsPowerOfTwo(uint64 N)
+{
+	return (N != 0) && !(N & (N - 1));
+}
+
+template <typename T>
+inline T Align(T Value, T Alignment)
+{
+	check(IsPowerOfTwo(Alignment));
+	return (Value + (Alignment - 1)) & ~(Alignment - 1);
+}
+
+// Index of the lowest/highest set bit; Value can't be 0. 32 bit MSVC only has the 32 bit scans, so it does each half.
+inline uint32 GetLowestSetBit(uint64 Value)
+{
+#if defined(_MSC_VER) && defined(_M_IX86)
+	unsigned long Bit;
+	if (_BitScanForward(&Bit, (unsigned long)Value))
+	{
+		return (uint32)Bit;
+	}
+	_BitScanForward(&Bit, (unsigned long)(Value >> 32));
+	return (uint32)Bit + 32;
+#elif defined(_MSC_VER)
+	unsigned long Bit;
+	_BitScanForward64(&Bit, Value);
+	return (uint32)Bit;
+#else
+	return (uint32)__builtin_ctzll(Value);
+#endif
+}
+
+inline uint32 GetHighestSetBit(uint64 Value)
+{
+#if defined(_MSC_VER) && defined(_M_IX86)
+	unsigned long Bit;
+	if (_BitScanReverse(&Bit, (unsigned long)(Value >> 32)))
+	{
+		return (uint32)Bit + 32;
+	}
+	_BitScanReverse(&Bit, (unsigned long)Value);
+	return (uint32)Bit;
+#elif defined(_MSC_VER)
+	unsigned long Bit;
+	_BitScanReverse64(&Bit, Value);
+	return (uint32)Bit;
+#else
+	return 63 - (uint32)__builtin_clzll(Value);
+#endif
+}
@@ -390,67 +390,35 @@ FMemPage::FMemPage(VkDevice InDevice, VkDeviceSize Size, uint32 InMemTypeIndex,
 	: Allocation(InDevice, Size, MemTypeIndex, bInMapped)
 	, MemTypeIndex(InMemTypeIndex)
 {
-	FRange Block;
-	Block.Begin = 0;
-	Block.End = Size;
-	FreeList.push_back(Block);
+	Ranges.Create(Size);
 }
 
 FMemPage::~FMemPage()
 {
-	check(FreeList.size() == 1);
+	check(Ranges.IsEmpty());
 	check(SubAllocations.empty());
 	Allocation.Destroy();
 }
 
 FMemSubAlloc* FMemPage::TryAlloc(uint64 Size, uint64 Alignment)
 {
-	for (auto& Range : FreeList)
+	uint64 Offset = 0;
+	const uint32 Block = Ranges.Alloc(Size, Alignment, Offset);
+	if (Block == FTLSFAllocator::INVALID_BLOCK)
 	{
-		uint64 AlignedOffset = Align(Range.Begin, Alignment);
-		if (AlignedOffset + Size <= Range.End)
-		{
-			auto* SubAlloc = new FMemSubAlloc(Range.Begin, AlignedOffset, Size, this);
-			SubAllocations.push_back(SubAlloc);
-			Range.Begin = AlignedOffset + Size;
-			return SubAlloc;
-		}
+		return nullptr;
 	}
 
-	return nullptr;
+	auto* SubAlloc = new FMemSubAlloc(Block, Offset, Size, this);
+	SubAllocations.push_back(SubAlloc);
+	return SubAlloc;
 }
 
 void FMemPage::Release(FMemSubAlloc* SubAlloc)
 {
-	FRange NewRange;
-	NewRange.Begin = SubAlloc->AllocatedOffset;
-	NewRange.End = SubAlloc->AllocatedOffset + SubAlloc->Size;
-	FreeList.push_back(NewRange);
+	Ranges.Free(SubAlloc->Block);
 	SubAllocations.remove(SubAlloc);
 	delete SubAlloc;
-
-	{
-		std::sort(FreeList.begin(), FreeList.end(),
-			[](const FRange& Left, const FRange& Right)
-		{
-			return Left.Begin < Right.Begin;
-		});
-
-		for (uint32 Index = (uint32)FreeList.size() - 1; Index > 0; --Index)
-		{
-			auto& Current = FreeList[Index];
-			auto& Prev = FreeList[Index - 1];
-			if (Current.Begin == Prev.End)
-			{
-				Prev.End = Current.End;
-				for (uint32 SubIndex = Index; SubIndex < FreeList.size() - 1; ++SubIndex)
-				{
-					FreeList[SubIndex] = FreeList[SubIndex + 1];
-				}
-				FreeList.resize(FreeList.size() - 1);
-			}
-		}
-	}
 }
 
 void FCmdBuffer::BeginRenderPass(VkRenderPass RenderPass, const FFramebuffer& Framebuffer, bool bHasSecondary)
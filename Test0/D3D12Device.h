@@ -130,6 +130,38 @@ struct FFence
 	}
 };
 
+// Signaled once per frame after its last submit, going up by one each time. Anything that has to outlive the GPU's use
+// of it for a frame (FUploadRing, FMemManager::Release()) waits on this same fence.
+struct FFrameFence
+{
+	Microsoft::WRL::ComPtr<ID3D12Fence> Fence;
+	uint64 LastSignaledValue = 0;
+
+	void Create(FDevice& InDevice)
+	{
+		checkD3D12(InDevice.Device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&Fence)));
+		LastSignaledValue = 0;
+	}
+
+	void Destroy()
+	{
+		Fence = nullptr;
+	}
+
+	// Returns the value signaled
+	uint64 Signal(ID3D12CommandQueue* Queue)
+	{
+		++LastSignaledValue;
+		checkD3D12(Queue->Signal(Fence.Get(), LastSignaledValue));
+		return LastSignaledValue;
+	}
+
+	uint64 GetCompletedValue() const
+	{
+		return Fence->GetCompletedValue();
+	}
+};
+
 struct FCmdBuffer
 {
 	Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> CommandList;
@@ -3,17 +3,12 @@
 #pragma once
 
 #include "D3D12Device.h"
+#include "Allocators.h"
 
 #if ENABLE_VULKAN
 
 class FMemSubAlloc;
 
-struct FRange
-{
-	uint64 Begin;
-	uint64 End;
-};
-
 enum
 {
 	DEFAULT_PAGE_SIZE = 16 * 1024 * 1024
@@ -85,7 +80,7 @@ public:
 
 protected:
 	uint32 MemTypeIndex;
-	std::vector<FRange> FreeList;
+	FTLSFAllocator Ranges;
 	std::list<FMemSubAlloc*> SubAllocations;
 
 	FMemAllocation Allocation;
@@ -98,8 +93,8 @@ protected:
 class FMemSubAlloc
 {
 public:
-	FMemSubAlloc(uint64 InAllocatedOffset, uint64 InAlignedOffset, uint64 InSize, FMemPage* InOwner)
-		: AllocatedOffset(InAllocatedOffset)
+	FMemSubAlloc(uint32 InBlock, uint64 InAlignedOffset, uint64 InSize, FMemPage* InOwner)
+		: Block(InBlock)
 		, AlignedOffset(InAlignedOffset)
 		, Size(InSize)
 		, Owner(InOwner)
@@ -108,7 +103,7 @@ public:
 
 	uint64 GetBindOffset() const
 	{
-		return AllocatedOffset;
+		return AlignedOffset;
 	}
 
 	VkDeviceMemory GetHandle() const
@@ -131,7 +126,7 @@ public:
 protected:
 	~FMemSubAlloc() {}
 
-	const uint64 AllocatedOffset;
+	const uint32 Block;
 	const uint64 AlignedOffset;
 	const uint64 Size;
 	FMemPage* Owner;
@@ -139,9 +134,46 @@ protected:
 };
 #endif
 
+// Allocations that can stand in for each other: same desc, heap type and initial state
+struct FResourceKey
+{
+	D3D12_RESOURCE_DESC Desc;
+	D3D12_HEAP_TYPE HeapType;
+	D3D12_RESOURCE_STATES ResourceStates;
+
+	static FResourceKey Make(D3D12_HEAP_TYPE HeapType, const D3D12_RESOURCE_DESC& Desc, D3D12_RESOURCE_STATES ResourceStates)
+	{
+		// Zeroed so padding doesn't break operator<
+		FResourceKey Key;
+		MemZero(Key);
+		Key.Desc = Desc;
+		Key.Desc.Alignment = 0;
+		Key.HeapType = HeapType;
+		Key.ResourceStates = ResourceStates;
+		return Key;
+	}
+
+	bool operator<(const FResourceKey& Other) const
+	{
+		return memcmp(this, &Other, sizeof(FResourceKey)) < 0;
+	}
+};
+
 struct FResourceAllocation
 {
 	Microsoft::WRL::ComPtr<ID3D12Resource> Resource;
+	FResourceKey Key;
+
+	// Where the resource was placed; invalid for committed resources
+	FHeapSuballocation Suballocation;
+
+	// Memory used as reported by GetResourceAllocationInfo(), and where FMemStats counted it
+	uint64 Size = 0;
+	EMemCategory Category = EMemCategory::Buffer;
+	uint32 StatsNameIndex = 0;
+
+	// Where it is in FMemManager's BufferAllocations or ResourceAllocations, so freeing it doesn't have to search
+	uint32 ListIndex = 0;
 };
 
 struct FBufferAllocation : public FResourceAllocation
@@ -149,26 +181,66 @@ struct FBufferAllocation : public FResourceAllocation
 	void* MappedData = nullptr;
 };
 
+// Placed resources come from heaps of this size; resources over half of it stay committed
+enum
+{
+	HEAP_PAGE_SIZE = 64 * 1024 * 1024
+};
+
+// Released resources are kept around for reuse for this many frames after the GPU is done with them
+enum
+{
+	MAX_RECYCLE_AGE = 60
+};
+
+// Tier 1 heaps can only hold one of these, so they get separate pages
+enum class EHeapResourceClass : uint32
+{
+	Buffer,
+	Texture,
+	RenderTarget,
+	Num
+};
+
 struct FMemManager
 {
 	void Create(FDevice& InDevice)
 	{
+		HeapSuballocator.Create(HEAP_PAGE_SIZE);
 #if ENABLE_VULKAN
 		vkGetPhysicalDeviceMemoryProperties(PhysicalDevice, &Properties);
 		check(Properties.memoryTypeCount != 0 && Properties.memoryHeapCount != 0);
 #endif
 	}
 
+	// The GPU has to be idle; anything released or pooled is still in the lists below
 	void Destroy()
 	{
+		Recycler.Clear();
 		for (auto* Buffer : BufferAllocations)
 		{
 			if (Buffer->MappedData)
 			{
 				Buffer->Resource->Unmap(0, nullptr);
 			}
+			Stats.OnFree(Buffer->Category, Buffer->StatsNameIndex, Buffer->Size);
 			delete Buffer;
 		}
+		BufferAllocations.clear();
+		for (auto* Resource : ResourceAllocations)
+		{
+			Stats.OnFree(Resource->Category, Resource->StatsNameIndex, Resource->Size);
+			delete Resource;
+		}
+		ResourceAllocations.clear();
+
+		// After the resources placed in them
+		for (uint32 Index = 0; Index < (uint32)Heaps.size(); ++Index)
+		{
+			Stats.OnHeapDestroyed(HeapSuballocator.GetPageSize());
+		}
+		Heaps.clear();
+		HeapSuballocator.Destroy();
 #if ENABLE_VULKAN
 		auto Free = [&](auto& PageMap)
 		{
@@ -207,7 +279,6 @@ struct FMemManager
 	{
 		const uint32 MemTypeIndex = GetMemTypeIndex(Reqs.memoryTypeBits, MemPropertyFlags);
 		auto& Pages = (bImage ? ImagePages : BufferPages)[MemTypeIndex];
-#if 0
 		for (auto& Page : Pages)
 		{
 			auto* SubAlloc = Page->TryAlloc(Reqs.size, Reqs.alignment);
@@ -216,7 +287,7 @@ struct FMemManager
 				return SubAlloc;
 			}
 		}
-#endif
+		// A page exactly as big as the request works: FTLSFAllocator::Alloc() also looks in the request's own list
 		const uint64 PageSize = max(DEFAULT_PAGE_SIZE, Reqs.size);
 		const bool bMapped = (MemPropertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) == VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
 		auto* NewPage = new FMemPage(Device, PageSize, MemTypeIndex, bMapped);
@@ -232,13 +303,230 @@ struct FMemManager
 	std::map<uint32, std::list<FMemPage*>> ImagePages;
 #endif
 
-	std::list<FBufferAllocation*> BufferAllocations;
-	std::list<FResourceAllocation*> ResourceAllocations;
+	// Unordered; see AddToList()/RemoveFromList()
+	std::vector<FBufferAllocation*> BufferAllocations;
+	std::vector<FResourceAllocation*> ResourceAllocations;
 
-	FBufferAllocation* AllocBuffer(LPCWSTR Name, FDevice& InDevice, uint64 InSize, D3D12_RESOURCE_STATES ResourceStates, D3D12_RESOURCE_FLAGS ResourceFlags, bool bUploadCPU)
+	template <typename TAllocation>
+	static void AddToList(std::vector<TAllocation*>& List, TAllocation* Allocation)
 	{
-		auto* NewBuffer = new FBufferAllocation;
+		Allocation->ListIndex = (uint32)List.size();
+		List.push_back(Allocation);
+	}
+
+	// The last one takes its place
+	template <typename TAllocation>
+	static void RemoveFromList(std::vector<TAllocation*>& List, TAllocation* Allocation)
+	{
+		check(Allocation->ListIndex < (uint32)List.size() && List[Allocation->ListIndex] == Allocation);
+		List[Allocation->ListIndex] = List.back();
+		List[Allocation->ListIndex]->ListIndex = Allocation->ListIndex;
+		List.pop_back();
+	}
+
+	FHeapSuballocator HeapSuballocator;
+
+	// Everything allocated through AllocBuffer() and AllocTexture2D()
+	FMemStats Stats;
+
+	// Last FFrameFence value given to EndFrame(); Release() waits for the next one
+	uint64 FrameFenceValue = 0;
+	FRecycler<FResourceKey, FResourceAllocation*> Recycler;
+
+	// The allocation can't be used afterwards. It's only destroyed, or handed out again by AllocBuffer() or
+	// AllocTexture2D() with the same parameters, once the GPU is done with this frame; it has to be back in the state
+	// it was created in by then.
+	void Release(FResourceAllocation* Allocation)
+	{
+		Recycler.Release(Allocation->Key, Allocation, FrameFenceValue + 1);
+	}
+
+	// Call with the frame fence value signaled after the frame's last command list
+	void EndFrame(uint64 SignaledFenceValue, uint64 CompletedFenceValue)
+	{
+		check(SignaledFenceValue == FrameFenceValue + 1);
+		FrameFenceValue = SignaledFenceValue;
+		Recycler.Process(CompletedFenceValue, MAX_RECYCLE_AGE, [&](FResourceAllocation* Allocation)
+			{
+				FreeAllocation(Allocation);
+			});
+	}
+
+	// Unnamed if Name is null or doesn't convert (eg too long for OutName)
+	static void GetStatsName(LPCWSTR Name, char (&OutName)[256])
+	{
+		if (!Name || !::WideCharToMultiByte(CP_UTF8, 0, Name, -1, OutName, sizeof(OutName), nullptr, nullptr))
+		{
+			strcpy_s(OutName, "Unnamed");
+		}
+		OutName[sizeof(OutName) - 1] = 0;
+	}
+
+	FResourceAllocation* TryReuse(LPCWSTR Name, const FResourceKey& Key)
+	{
+		FResourceAllocation* Allocation = nullptr;
+		if (!Recycler.Acquire(Key, Allocation))
+		{
+			return nullptr;
+		}
+
+		// Count it under its new name
+		char StatsName[256];
+		GetStatsName(Name, StatsName);
+		Stats.OnFree(Allocation->Category, Allocation->StatsNameIndex, Allocation->Size);
+		Allocation->StatsNameIndex = Stats.OnAlloc(Allocation->Category, StatsName, Allocation->Size);
+		Allocation->Resource->SetName(Name);
+		return Allocation;
+	}
+
+	void FreeAllocation(FResourceAllocation* Allocation)
+	{
+		Stats.OnFree(Allocation->Category, Allocation->StatsNameIndex, Allocation->Size);
+		if (Allocation->Suballocation.IsValid())
+		{
+			HeapSuballocator.Free(Allocation->Suballocation);
+		}
+		if (Allocation->Key.Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		{
+			auto* Buffer = (FBufferAllocation*)Allocation;
+			if (Buffer->MappedData)
+			{
+				Buffer->Resource->Unmap(0, nullptr);
+			}
+			RemoveFromList(BufferAllocations, Buffer);
+			delete Buffer;
+		}
+		else
+		{
+			RemoveFromList(ResourceAllocations, Allocation);
+			delete Allocation;
+		}
+	}
+
+	// One per HeapSuballocator page
+	std::vector<Microsoft::WRL::ComPtr<ID3D12Heap>> Heaps;
+
+	static D3D12_HEAP_PROPERTIES GetHeapProperties(D3D12_HEAP_TYPE Type)
+	{
+		D3D12_HEAP_PROPERTIES Heap;
+		MemZero(Heap);
+		Heap.Type = Type;
+		Heap.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
+		Heap.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
+		Heap.CreationNodeMask = 1;
+		Heap.VisibleNodeMask = 1;
+		return Heap;
+	}
+
+	static EHeapResourceClass GetHeapResourceClass(const D3D12_RESOURCE_DESC& Desc)
+	{
+		if (Desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+		{
+			return EHeapResourceClass::Buffer;
+		}
+		return (Desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) ? EHeapResourceClass::RenderTarget : EHeapResourceClass::Texture;
+	}
+
+	static D3D12_HEAP_FLAGS GetHeapFlags(EHeapResourceClass Class)
+	{
+		switch (Class)
+		{
+		case EHeapResourceClass::Buffer:
+			return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+		case EHeapResourceClass::Texture:
+			return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+		case EHeapResourceClass::RenderTarget:
+			return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+		default:
+			check(0);
+			return D3D12_HEAP_FLAG_NONE;
+		}
+	}
+
+	static EMemCategory GetMemCategory(D3D12_HEAP_TYPE HeapType, EHeapResourceClass Class)
+	{
+		if (HeapType == D3D12_HEAP_TYPE_UPLOAD)
+		{
+			return EMemCategory::Upload;
+		}
+		switch (Class)
+		{
+		case EHeapResourceClass::Buffer:
+			return EMemCategory::Buffer;
+		case EHeapResourceClass::Texture:
+			return EMemCategory::Texture;
+		default:
+			return EMemCategory::RenderTarget;
+		}
+	}
+
+	// Places the resource in a heap page, or makes it committed if it's too big for one
+	void CreateResource(LPCWSTR Name, FDevice& InDevice, D3D12_HEAP_TYPE HeapType, D3D12_RESOURCE_DESC& Desc, D3D12_RESOURCE_STATES ResourceStates, const D3D12_CLEAR_VALUE* ClearValue, FResourceAllocation* OutAllocation)
+	{
+		OutAllocation->Key = FResourceKey::Make(HeapType, Desc, ResourceStates);
+
+		// Small textures can use 4KB alignment instead of 64KB if the driver agrees
+		D3D12_RESOURCE_ALLOCATION_INFO Info;
+		if (Desc.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER && Desc.SampleDesc.Count == 1 && !(Desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)))
+		{
+			Desc.Alignment = D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT;
+			Info = InDevice.Device->GetResourceAllocationInfo(0, 1, &Desc);
+			if (Info.Alignment != D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT)
+			{
+				Desc.Alignment = 0;
+				Info = InDevice.Device->GetResourceAllocationInfo(0, 1, &Desc);
+			}
+		}
+		else
+		{
+			Desc.Alignment = 0;
+			Info = InDevice.Device->GetResourceAllocationInfo(0, 1, &Desc);
+		}
+
+		const EHeapResourceClass Class = GetHeapResourceClass(Desc);
+		char StatsName[256];
+		GetStatsName(Name, StatsName);
+		OutAllocation->Size = Info.SizeInBytes;
+		OutAllocation->Category = GetMemCategory(HeapType, Class);
+		OutAllocation->StatsNameIndex = Stats.OnAlloc(OutAllocation->Category, StatsName, Info.SizeInBytes);
+
+		// MSAA needs 4MB aligned heaps, so leave those committed too
+		if (Desc.SampleDesc.Count > 1 || !HeapSuballocator.CanSuballocate(Info.SizeInBytes, Info.Alignment))
+		{
+			D3D12_HEAP_PROPERTIES Heap = GetHeapProperties(HeapType);
+			checkD3D12(InDevice.Device->CreateCommittedResource(&Heap, D3D12_HEAP_FLAG_NONE, &Desc, ResourceStates, ClearValue, IID_PPV_ARGS(&OutAllocation->Resource)));
+			return;
+		}
+
+		const uint32 Pool = (uint32)HeapType * (uint32)EHeapResourceClass::Num + (uint32)Class;
+		bool bNewPage = false;
+		OutAllocation->Suballocation = HeapSuballocator.Alloc(Pool, Info.SizeInBytes, Info.Alignment, bNewPage);
+		if (bNewPage)
+		{
+			D3D12_HEAP_DESC HeapDesc;
+			MemZero(HeapDesc);
+			HeapDesc.SizeInBytes = HeapSuballocator.GetPageSize();
+			HeapDesc.Properties = GetHeapProperties(HeapType);
+			HeapDesc.Alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+			HeapDesc.Flags = GetHeapFlags(Class);
+
+			check(OutAllocation->Suballocation.Page == (uint32)Heaps.size());
+			Heaps.emplace_back();
+			checkD3D12(InDevice.Device->CreateHeap(&HeapDesc, IID_PPV_ARGS(&Heaps.back())));
+			Stats.OnHeapCreated(HeapDesc.SizeInBytes);
+		}
+
+		checkD3D12(InDevice.Device->CreatePlacedResource(
+			Heaps[OutAllocation->Suballocation.Page].Get(),
+			OutAllocation->Suballocation.Offset,
+			&Desc,
+			ResourceStates,
+			ClearValue,
+			IID_PPV_ARGS(&OutAllocation->Resource)));
+	}
 
+	FBufferAllocation* AllocBuffer(LPCWSTR Name, FDevice& InDevice, uint64 InSize, D3D12_RESOURCE_STATES ResourceStates, D3D12_RESOURCE_FLAGS ResourceFlags, bool bUploadCPU)
+	{
 		D3D12_RESOURCE_DESC Desc;
 		MemZero(Desc);
 		Desc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
@@ -251,38 +539,31 @@ struct FMemManager
 		Desc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
 		Desc.Flags = ResourceFlags;
 
-		D3D12_HEAP_PROPERTIES Heap;
-		MemZero(Heap);
-		Heap.Type = bUploadCPU ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT;
-		Heap.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-		Heap.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-		Heap.CreationNodeMask = 1;
-		Heap.VisibleNodeMask = 1;
+		const D3D12_HEAP_TYPE HeapType = bUploadCPU ? D3D12_HEAP_TYPE_UPLOAD : D3D12_HEAP_TYPE_DEFAULT;
+		const D3D12_RESOURCE_STATES InitialStates = (D3D12_RESOURCE_STATES)(ResourceStates | (bUploadCPU ? D3D12_RESOURCE_STATE_GENERIC_READ : 0));
+		if (auto* Reused = TryReuse(Name, FResourceKey::Make(HeapType, Desc, InitialStates)))
+		{
+			// Still mapped if it was
+			return (FBufferAllocation*)Reused;
+		}
 
-		checkD3D12(InDevice.Device->CreateCommittedResource(
-			&Heap,
-			D3D12_HEAP_FLAG_NONE,
-			&Desc,
-			(D3D12_RESOURCE_STATES)(ResourceStates | (bUploadCPU ? D3D12_RESOURCE_STATE_GENERIC_READ : 0)),
-			nullptr,
-			IID_PPV_ARGS(&NewBuffer->Resource)));
+		auto* NewBuffer = new FBufferAllocation;
+		CreateResource(Name, InDevice, HeapType, Desc, InitialStates, nullptr, NewBuffer);
 		if (bUploadCPU)
 		{
 			D3D12_RANGE ReadRange;
 			MemZero(ReadRange);
 			checkD3D12(NewBuffer->Resource->Map(0, &ReadRange, &NewBuffer->MappedData));
 		}
-		BufferAllocations.push_back(NewBuffer);
+		AddToList(BufferAllocations, NewBuffer);
 		NewBuffer->Resource->SetName(Name);
 		return NewBuffer;
 	}
 
 
 
-	FResourceAllocation* AllocTexture2D(FDevice& InDevice, uint32 Width, uint32 Height, DXGI_FORMAT Format, bool bUploadCPU, D3D12_RESOURCE_FLAGS ResourceFlags)
+	FResourceAllocation* AllocTexture2D(LPCWSTR Name, FDevice& InDevice, uint32 Width, uint32 Height, DXGI_FORMAT Format, bool bUploadCPU, D3D12_RESOURCE_FLAGS ResourceFlags)
 	{
-		auto* NewResource = new FResourceAllocation;
-
 		D3D12_RESOURCE_DESC Desc;
 		MemZero(Desc);
 		Desc.MipLevels = 1;
@@ -295,119 +576,30 @@ struct FMemManager
 		Desc.SampleDesc.Quality = 0;
 		Desc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
 
-		D3D12_HEAP_PROPERTIES Heap;
-		MemZero(Heap);
-		Heap.Type = D3D12_HEAP_TYPE_DEFAULT;
-		Heap.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN;
-		Heap.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN;
-		Heap.CreationNodeMask = 1;
-		Heap.VisibleNodeMask = 1;
-
 		D3D12_CLEAR_VALUE ClearValue;
 		MemZero(ClearValue);
 		ClearValue.Format = Format;
 		ClearValue.DepthStencil.Depth = 1;
 
-		checkD3D12(InDevice.Device->CreateCommittedResource(
-			&Heap,
-			D3D12_HEAP_FLAG_NONE,
-			&Desc,
-			IsDepthOrStencilFormat(Format) ? D3D12_RESOURCE_STATE_DEPTH_WRITE : D3D12_RESOURCE_STATE_COMMON,
-			IsDepthOrStencilFormat(Format) ? &ClearValue : nullptr,
-			IID_PPV_ARGS(&NewResource->Resource)));
-		ResourceAllocations.push_back(NewResource);
-		return NewResource;
-	}
-
-
-};
-
-struct FRecyclableResource
-{
-};
-
-#if 0
-class FResourceRecycler
-{
-public:
-	enum class EType
-	{
-		Semaphore,
-	};
-
-	void Deinit()
-	{
-		check(Entries.empty());
-	}
-
-	inline void EnqueueResource(FSemaphore* Semaphore, FCmdBuffer* CmdBuffer)
-	{
-		EnqueueGenericResource(Semaphore, EType::Semaphore, CmdBuffer);
-	}
-
-	void Process()
-	{
-		std::list<FEntry*> NewList;
-		for (auto* Entry : Entries)
+		const D3D12_RESOURCE_STATES InitialStates = IsDepthOrStencilFormat(Format) ? D3D12_RESOURCE_STATE_DEPTH_WRITE : D3D12_RESOURCE_STATE_COMMON;
+		if (auto* Reused = TryReuse(Name, FResourceKey::Make(D3D12_HEAP_TYPE_DEFAULT, Desc, InitialStates)))
 		{
-			if (Entry->HasFencePassed())
-			{
-				AvailableResources.push_back(Entry);
-			}
-			else
-			{
-				NewList.push_back(Entry);
-			}
+			return Reused;
 		}
 
-		Entries.swap(NewList);
-	}
-
-	FSemaphore* AcquireSemaphore()
-	{
-		return AcquireGeneric<FSemaphore, EType::Semaphore>();
-	}
-
-protected:
-	void EnqueueGenericResource(FRecyclableResource* Resource, EType Type, FCmdBuffer* CmdBuffer)
-	{
-		auto* NewEntry = new FEntry(CmdBuffer, Type, Resource);
-		Entries.push_back(NewEntry);
-	}
-
-	template <typename T, EType Type>
-	T* AcquireGeneric()
-	{
-		for (auto* Entry : AvailableResources)
-		{
-			if (Entry->Type == Type)
-			{
-				T* Found = Entry->Resource;
-				AvailableResources.remove(Entry);
-				delete Entry;
-				return Found;
-			}
-		}
-
-		return nullptr;
+		auto* NewResource = new FResourceAllocation;
+		CreateResource(
+			Name,
+			InDevice,
+			D3D12_HEAP_TYPE_DEFAULT,
+			Desc,
+			InitialStates,
+			IsDepthOrStencilFormat(Format) ? &ClearValue : nullptr,
+			NewResource);
+		AddToList(ResourceAllocations, NewResource);
+		NewResource->Resource->SetName(Name);
+		return NewResource;
 	}
 
-	struct FEntry : public FCmdBufferFence
-	{
-		FRecyclableResource* Resource;
-		EType Type;
 
-		FEntry(FCmdBuffer* InBuffer, EType InType, FRecyclableResource* InResource)
-			: FCmdBufferFence(InBuffer)
-			, Resource(InResource)
-			, Type(InType)
-		{
-		}
-	};
-
-	std::list<FEntry*> Entries;
-	std::list<FEntry*> AvailableResources;
 };
-
-FResourceRecycler GResourceRecycler;
-#endif
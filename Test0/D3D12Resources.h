@@ -16,14 +16,21 @@ struct FBuffer
 	{
 		Size = InSize;
 
+		MemManager = &MemMgr;
 		Alloc = MemMgr.AllocBuffer(Name, InDevice, InSize, ResourceStates, ResourceFlags, bUploadCPU);
 	}
 
+	// Safe to call while the GPU is still using the buffer; see FMemManager::Release()
 	void Destroy()
 	{
 #if ENABLE_VULKAN
 		SubAlloc->Release();
 #endif
+		if (Alloc)
+		{
+			MemManager->Release(Alloc);
+			Alloc = nullptr;
+		}
 	}
 
 	void* GetMappedData()
@@ -38,6 +45,7 @@ struct FBuffer
 	}
 
 	FBufferAllocation* Alloc = nullptr;
+	FMemManager* MemManager = nullptr;
 	uint64 Size = 0;
 };
 
@@ -159,12 +167,62 @@ struct FUniformBuffer
 	FBuffer Buffer;
 };
 
+// Constants and other data that only live for a frame, bump allocated out of one persistently mapped upload buffer.
+// A fence is signaled after each frame's submit, and the frame's allocations are only handed out again once it passes.
+struct FUploadRing
+{
+	// Size has to be a power of two
+	void Create(FDevice& InDevice, FMemManager& MemMgr, FFrameFence& InFrameFence, uint64 Size)
+	{
+		Buffer.Create(L"UploadRing", InDevice, Size, MemMgr, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER, D3D12_RESOURCE_FLAG_NONE, true);
+		BaseAddress = Buffer.Alloc->Resource->GetGPUVirtualAddress();
+		Ring.Create(Size);
+		FrameFence = &InFrameFence;
+	}
+
+	void Destroy()
+	{
+		FrameFence = nullptr;
+		Buffer.Destroy();
+	}
+
+	// Call with the frame fence value signaled after the last command list that uses this frame's allocations
+	void EndFrame(uint64 SignaledFenceValue, uint64 CompletedFenceValue)
+	{
+		Ring.EndFrame(SignaledFenceValue);
+		Ring.Retire(CompletedFenceValue);
+	}
+
+	// Copies Data in and returns its address for SetGraphicsRootConstantBufferView() and friends
+	template <typename TStruct>
+	D3D12_GPU_VIRTUAL_ADDRESS Alloc(const TStruct& Data)
+	{
+		const uint64 Size = Align((uint64)sizeof(TStruct), (uint64)D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+		uint64 Offset = 0;
+		while (!Ring.Alloc(Size, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, Offset))
+		{
+			// Full of frames the GPU hasn't finished yet; if there are none the ring is too small for one frame
+			check(Ring.GetNumFramesInFlight() > 0);
+			::Sleep(0);
+			Ring.Retire(FrameFence->GetCompletedValue());
+		}
+		memcpy((uint8*)Buffer.GetMappedData() + Offset, &Data, sizeof(TStruct));
+		return BaseAddress + Offset;
+	}
+
+	FBuffer Buffer;
+	D3D12_GPU_VIRTUAL_ADDRESS BaseAddress = 0;
+	FRingAllocator Ring;
+	FFrameFence* FrameFence = nullptr;
+};
+
 struct FImage
 {
 	//Microsoft::WRL::ComPtr<ID3D12Resource> Texture;
 	FResourceAllocation* Alloc = nullptr;
+	FMemManager* MemManager = nullptr;
 
-	void Create(FDevice& InDevice, uint32 InWidth, uint32 InHeight, DXGI_FORMAT InFormat, FMemManager& MemMgr, D3D12_RESOURCE_FLAGS ResourceFlags = D3D12_RESOURCE_FLAG_NONE
+	void Create(LPCWSTR Name, FDevice& InDevice, uint32 InWidth, uint32 InHeight, DXGI_FORMAT InFormat, FMemManager& MemMgr, D3D12_RESOURCE_FLAGS ResourceFlags = D3D12_RESOURCE_FLAG_NONE
 #if ENABLE_VULKAN
 		uint32 InNumMips, VkSampleCountFlagBits InSamples
 #endif
@@ -178,9 +236,11 @@ struct FImage
 		NumMips = InNumMips;
 		Samples = InSamples;
 #endif
-		Alloc = MemMgr.AllocTexture2D(InDevice, Width, Height, Format, false, ResourceFlags);
+		MemManager = &MemMgr;
+		Alloc = MemMgr.AllocTexture2D(Name, InDevice, Width, Height, Format, false, ResourceFlags);
 	}
 
+	// Safe to call while the GPU is still using the image; see FMemManager::Release()
 	void Destroy()
 	{
 #if ENABLE_VULKAN
@@ -189,6 +249,11 @@ struct FImage
 
 		SubAlloc->Release();
 #endif
+		if (Alloc)
+		{
+			MemManager->Release(Alloc);
+			Alloc = nullptr;
+		}
 	}
 
 #if ENABLE_VULKAN
@@ -340,13 +405,13 @@ inline VkImageAspectFlags GetImageAspectFlags(VkFormat Format)
 
 struct FImage2DWithView
 {
-	void Create(FDevice& InDevice, uint32 InWidth, uint32 InHeight, DXGI_FORMAT Format, FDescriptorPool& Pool, FMemManager& MemMgr, D3D12_RESOURCE_FLAGS ResourceFlags = D3D12_RESOURCE_FLAG_NONE
+	void Create(LPCWSTR Name, FDevice& InDevice, uint32 InWidth, uint32 InHeight, DXGI_FORMAT Format, FDescriptorPool& Pool, FMemManager& MemMgr, D3D12_RESOURCE_FLAGS ResourceFlags = D3D12_RESOURCE_FLAG_NONE
 #if ENABLE_VULKAN
 		, uint32 InNumMips = 1, VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT
 #endif
 	)
 	{
-		Image.Create(InDevice, InWidth, InHeight, Format, MemMgr, ResourceFlags
+		Image.Create(Name, InDevice, InWidth, InHeight, Format, MemMgr, ResourceFlags
 #if ENABLE_VULKAN
 			, InNumMips, Samples
 #endif
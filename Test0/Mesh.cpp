@@ -0,0 +1,1508 @@
+#include "stdafx.h"
+#include "Util.h"
+#include "Mesh.h"
+#include <float.h>
+#if ENABLE_SIMD
+#include <emmintrin.h>
+#endif
+
+FVertexCacheStats AnalyzeVertexCache(const FIndexedMesh& Mesh, uint32 CacheSize)
+{
+	// FIFO cache: a vertex is a hit while fewer than CacheSize misses happened since it was loaded
+	std::vector<uint32> LoadedAt(Mesh.Vertices.size(), 0);
+	uint32 NumMisses = 0;
+	for (uint32 Index : Mesh.Indices)
+	{
+		if (LoadedAt[Index] == 0 || NumMisses + 1 - LoadedAt[Index] > CacheSize)
+		{
+			++NumMisses;
+			LoadedAt[Index] = NumMisses;
+		}
+	}
+
+	// Only count vertices the index buffer actually references
+	uint32 NumUsed = 0;
+	for (uint32 Time : LoadedAt)
+	{
+		NumUsed += Time != 0 ? 1 : 0;
+	}
+
+	FVertexCacheStats Stats;
+	Stats.NumTransformed = NumMisses;
+	Stats.ACMR = Mesh.GetNumTriangles() ? (float)NumMisses / (float)Mesh.GetNumTriangles() : 0.0f;
+	Stats.ATVR = NumUsed ? (float)NumMisses / (float)NumUsed : 0.0f;
+	return Stats;
+}
+
+// Sander, Nehab, Barczak - "Fast Triangle Reordering for Vertex Locality and Reduced Overdraw" (Tipsify)
+void OptimizeVertexCache(FIndexedMesh& Mesh, uint32 CacheSize)
+{
+	const uint32 NumVertices = (uint32)Mesh.Vertices.size();
+	const uint32 NumTriangles = Mesh.GetNumTriangles();
+	if (NumTriangles == 0)
+	{
+		return;
+	}
+
+	// Vertex -> triangles adjacency
+	std::vector<uint32> AdjacencyOffsets(NumVertices + 1, 0);
+	for (uint32 Index : Mesh.Indices)
+	{
+		++AdjacencyOffsets[Index + 1];
+	}
+
+	for (uint32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		AdjacencyOffsets[Vertex + 1] += AdjacencyOffsets[Vertex];
+	}
+
+	std::vector<uint32> Adjacency(Mesh.Indices.size());
+	{
+		std::vector<uint32> Fill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+		for (uint32 Index = 0; Index < (uint32)Mesh.Indices.size(); ++Index)
+		{
+			Adjacency[Fill[Mesh.Indices[Index]]++] = Index / 3;
+		}
+	}
+
+	// Triangles never move between sections; a mesh without sections is one
+	std::vector<FMeshSection> Sections = Mesh.Sections;
+	if (Sections.empty())
+	{
+		FMeshSection Section = {0, 0, (uint32)Mesh.Indices.size()};
+		Sections.push_back(Section);
+	}
+
+	// LiveTriangles counts the triangles of the current section not emitted yet, so it's back to 0 after each one
+	std::vector<uint32> LiveTriangles(NumVertices, 0);
+	std::vector<uint32> CacheTime(NumVertices, 0);
+	std::vector<bool> Emitted(NumTriangles, false);
+	std::vector<uint32> DeadEnd;
+	std::vector<uint32> Candidates;
+	std::vector<uint32> NewIndices;
+	NewIndices.reserve(Mesh.Indices.size());
+
+	uint32 Time = CacheSize + 1;
+	for (const FMeshSection& Section : Sections)
+	{
+		if (Section.NumIndices < 3)
+		{
+			continue;
+		}
+
+		const uint32 FirstTriangle = Section.FirstIndex / 3;
+		const uint32 EndTriangle = FirstTriangle + Section.NumIndices / 3;
+		for (uint32 Index = Section.FirstIndex; Index < EndTriangle * 3; ++Index)
+		{
+			++LiveTriangles[Mesh.Indices[Index]];
+		}
+
+		DeadEnd.clear();
+		uint32 Cursor = Section.FirstIndex;
+		int32 Fanning = Mesh.Indices[Section.FirstIndex];
+		while (Fanning >= 0)
+		{
+			// Emit every remaining triangle around the fanning vertex
+			Candidates.clear();
+			for (uint32 Adj = AdjacencyOffsets[Fanning]; Adj < AdjacencyOffsets[Fanning + 1]; ++Adj)
+			{
+				uint32 Triangle = Adjacency[Adj];
+				if (Triangle < FirstTriangle || Triangle >= EndTriangle || Emitted[Triangle])
+				{
+					continue;
+				}
+
+				for (uint32 Corner = 0; Corner < 3; ++Corner)
+				{
+					uint32 Vertex = Mesh.Indices[Triangle * 3 + Corner];
+					NewIndices.push_back(Vertex);
+					DeadEnd.push_back(Vertex);
+					Candidates.push_back(Vertex);
+					--LiveTriangles[Vertex];
+					if (Time - CacheTime[Vertex] > CacheSize)
+					{
+						CacheTime[Vertex] = Time;
+						++Time;
+					}
+				}
+				Emitted[Triangle] = true;
+			}
+
+			// Next fanning vertex: the candidate that will still be in the cache after emitting all its triangles,
+			// preferring the oldest one
+			Fanning = -1;
+			int32 BestPriority = -1;
+			for (uint32 Vertex : Candidates)
+			{
+				if (LiveTriangles[Vertex] > 0)
+				{
+					int32 Priority = 0;
+					if (Time - CacheTime[Vertex] + 2 * LiveTriangles[Vertex] <= CacheSize)
+					{
+						Priority = Time - CacheTime[Vertex];
+					}
+
+					if (Priority > BestPriority)
+					{
+						BestPriority = Priority;
+						Fanning = Vertex;
+					}
+				}
+			}
+
+			if (Fanning == -1)
+			{
+				// Dead end: go back to recently used vertices, then to the next vertex in input order
+				while (!DeadEnd.empty())
+				{
+					uint32 Vertex = DeadEnd.back();
+					DeadEnd.pop_back();
+					if (LiveTriangles[Vertex] > 0)
+					{
+						Fanning = Vertex;
+						break;
+					}
+				}
+
+				while (Fanning == -1 && Cursor < EndTriangle * 3)
+				{
+					uint32 Vertex = Mesh.Indices[Cursor];
+					if (LiveTriangles[Vertex] > 0)
+					{
+						Fanning = Vertex;
+					}
+					++Cursor;
+				}
+			}
+		}
+	}
+
+	check(NewIndices.size() == Mesh.Indices.size());
+	Mesh.Indices.swap(NewIndices);
+}
+
+void OptimizeVertexFetch(FIndexedMesh& Mesh)
+{
+	// Number vertices in the order the index buffer first touches them; unreferenced vertices are dropped
+	std::vector<uint32> Remap(Mesh.Vertices.size(), (uint32)-1);
+	std::vector<FMeshVertex> NewVertices;
+	std::vector<FVector4> NewTangents;
+	NewVertices.reserve(Mesh.Vertices.size());
+	NewTangents.reserve(Mesh.Tangents.size());
+	for (uint32& Index : Mesh.Indices)
+	{
+		if (Remap[Index] == (uint32)-1)
+		{
+			Remap[Index] = (uint32)NewVertices.size();
+			NewVertices.push_back(Mesh.Vertices[Index]);
+			if (!Mesh.Tangents.empty())
+			{
+				NewTangents.push_back(Mesh.Tangents[Index]);
+			}
+		}
+		Index = Remap[Index];
+	}
+
+	Mesh.Vertices.swap(NewVertices);
+	Mesh.Tangents.swap(NewTangents);
+}
+
+static void ComputeMeshletBounds(const FIndexedMesh& Mesh, const FMeshlets& Meshlets, FMeshlet& Meshlet)
+{
+	const uint32* Vertices = &Meshlets.Vertices[Meshlet.FirstVertex];
+	const uint8* Triangles = &Meshlets.Triangles[Meshlet.FirstTriangle * 3];
+
+	// Sphere around the center of the box; not minimal but cheap and stable
+	FVector3 Min = Mesh.Vertices[Vertices[0]].Pos;
+	FVector3 Max = Min;
+	for (uint32 Index = 1; Index < Meshlet.NumVertices; ++Index)
+	{
+		const FVector3& Pos = Mesh.Vertices[Vertices[Index]].Pos;
+		Min.x = min(Min.x, Pos.x);
+		Min.y = min(Min.y, Pos.y);
+		Min.z = min(Min.z, Pos.z);
+		Max.x = max(Max.x, Pos.x);
+		Max.y = max(Max.y, Pos.y);
+		Max.z = max(Max.z, Pos.z);
+	}
+
+	Meshlet.Center = Min.Add(Max).Mul(0.5f);
+	float RadiusSquared = 0;
+	for (uint32 Index = 0; Index < Meshlet.NumVertices; ++Index)
+	{
+		FVector3 Delta = Mesh.Vertices[Vertices[Index]].Pos.Sub(Meshlet.Center);
+		RadiusSquared = max(RadiusSquared, Delta.Dot(Delta));
+	}
+	Meshlet.Radius = sqrt(RadiusSquared);
+
+	// Cone around the average face normal, as wide as the face normal furthest from it
+	std::vector<FVector3> Normals(Meshlet.NumTriangles);
+	FVector3 Sum = FVector3::GetZero();
+	for (uint32 Index = 0; Index < Meshlet.NumTriangles; ++Index)
+	{
+		const FVector3& A = Mesh.Vertices[Vertices[Triangles[Index * 3 + 0]]].Pos;
+		const FVector3& B = Mesh.Vertices[Vertices[Triangles[Index * 3 + 1]]].Pos;
+		const FVector3& C = Mesh.Vertices[Vertices[Triangles[Index * 3 + 2]]].Pos;
+		Normals[Index] = B.Sub(A).Cross(C.Sub(A)).GetNormalized();
+		Sum = Sum.Add(Normals[Index]);
+	}
+
+	Meshlet.ConeAxis = Sum.GetNormalized();
+	float MinDot = 1;
+	for (const FVector3& Normal : Normals)
+	{
+		// Degenerate triangles can't be seen anyway
+		if (Normal.Dot(Normal) > 0)
+		{
+			MinDot = min(MinDot, Normal.Dot(Meshlet.ConeAxis));
+		}
+	}
+
+	// Cutoff is the sine of the cone's half angle; a cone of 90 degrees or more can never be culled
+	Meshlet.ConeCutoff = MinDot <= 0 || Sum.Dot(Sum) == 0 ? 1.0f : sqrt(1.0f - MinDot * MinDot);
+}
+
+void BuildMeshlets(const FIndexedMesh& Mesh, FMeshlets& OutMeshlets, uint32 MaxVertices, uint32 MaxTriangles)
+{
+	check(MaxVertices >= 3 && MaxVertices <= 256 && MaxTriangles >= 1);
+	OutMeshlets.Meshlets.clear();
+	OutMeshlets.Vertices.clear();
+	OutMeshlets.Triangles.clear();
+
+	std::vector<FMeshSection> Sections = Mesh.Sections;
+	if (Sections.empty())
+	{
+		FMeshSection Section = {0, 0, (uint32)Mesh.Indices.size()};
+		Sections.push_back(Section);
+	}
+
+	// Which meshlet last used each vertex, and its local index there
+	std::vector<uint32> VertexMeshlet(Mesh.Vertices.size(), (uint32)-1);
+	std::vector<uint8> VertexLocalIndex(Mesh.Vertices.size());
+
+	FMeshlet Meshlet;
+	auto Begin = [&](uint32 Material)
+	{
+		MemZero(Meshlet);
+		Meshlet.Material = Material;
+		Meshlet.FirstVertex = (uint32)OutMeshlets.Vertices.size();
+		Meshlet.FirstTriangle = (uint32)OutMeshlets.Triangles.size() / 3;
+	};
+	auto Finish = [&]()
+	{
+		if (Meshlet.NumTriangles > 0)
+		{
+			ComputeMeshletBounds(Mesh, OutMeshlets, Meshlet);
+			OutMeshlets.Meshlets.push_back(Meshlet);
+		}
+	};
+
+	for (const FMeshSection& Section : Sections)
+	{
+		if (Section.Lod != 0)
+		{
+			continue;
+		}
+
+		Begin(Section.Material);
+		for (uint32 Index = Section.FirstIndex; Index + 2 < Section.FirstIndex + Section.NumIndices; Index += 3)
+		{
+			const uint32* Corners = &Mesh.Indices[Index];
+			const uint32 MeshletIndex = (uint32)OutMeshlets.Meshlets.size();
+			uint32 NumNewVertices = 0;
+			for (uint32 Corner = 0; Corner < 3; ++Corner)
+			{
+				NumNewVertices += VertexMeshlet[Corners[Corner]] != MeshletIndex ? 1 : 0;
+			}
+
+			if (Meshlet.NumVertices + NumNewVertices > MaxVertices || Meshlet.NumTriangles + 1 > MaxTriangles)
+			{
+				Finish();
+				Begin(Section.Material);
+			}
+
+			// Begin() may have changed the meshlet index
+			const uint32 CurrentMeshlet = (uint32)OutMeshlets.Meshlets.size();
+			for (uint32 Corner = 0; Corner < 3; ++Corner)
+			{
+				const uint32 Vertex = Corners[Corner];
+				if (VertexMeshlet[Vertex] != CurrentMeshlet)
+				{
+					VertexMeshlet[Vertex] = CurrentMeshlet;
+					VertexLocalIndex[Vertex] = (uint8)Meshlet.NumVertices++;
+					OutMeshlets.Vertices.push_back(Vertex);
+				}
+				OutMeshlets.Triangles.push_back(VertexLocalIndex[Vertex]);
+			}
+			++Meshlet.NumTriangles;
+		}
+		Finish();
+	}
+}
+
+void CullMeshlets(const FMeshlets& Meshlets, const FFrustum& Frustum, const FVector3& CameraPos, std::vector<uint32>& OutVisible)
+{
+	OutVisible.clear();
+	for (uint32 Index = 0; Index < (uint32)Meshlets.Meshlets.size(); ++Index)
+	{
+		const FMeshlet& Meshlet = Meshlets.Meshlets[Index];
+		if (!Frustum.IsSphereVisible(Meshlet.Center, Meshlet.Radius))
+		{
+			continue;
+		}
+
+		FVector3 View = Meshlet.Center.Sub(CameraPos);
+		if (View.Dot(Meshlet.ConeAxis) >= Meshlet.ConeCutoff * View.Length() + Meshlet.Radius)
+		{
+			continue;
+		}
+
+		OutVisible.push_back(Index);
+	}
+}
+
+FMeshBounds ComputeMeshBounds(const FMeshVertex* Vertices, uint32 NumVertices)
+{
+	FMeshBounds Bounds;
+	Bounds.Box = FBox::GetEmpty();
+	Bounds.Sphere.Center = {{{0, 0, 0}}};
+	Bounds.Sphere.Radius = 0;
+	if (NumVertices == 0)
+	{
+		return Bounds;
+	}
+
+	for (uint32 Index = 0; Index < NumVertices; ++Index)
+	{
+		Bounds.Box.Add(Vertices[Index].Pos);
+	}
+
+	auto GetFarthest = [&](const FVector3& From)
+	{
+		uint32 Farthest = 0;
+		float FarthestDistanceSquared = -1;
+		for (uint32 Index = 0; Index < NumVertices; ++Index)
+		{
+			const FVector3 Delta = Vertices[Index].Pos.Sub(From);
+			const float DistanceSquared = Delta.Dot(Delta);
+			if (DistanceSquared > FarthestDistanceSquared)
+			{
+				Farthest = Index;
+				FarthestDistanceSquared = DistanceSquared;
+			}
+		}
+		return Farthest;
+	};
+
+	// Ritter: start from the two points farthest apart along one sweep, then grow to take in every point left outside
+	const FVector3& A = Vertices[GetFarthest(Vertices[0].Pos)].Pos;
+	const FVector3& B = Vertices[GetFarthest(A)].Pos;
+	FVector3 Center = A.Add(B).Mul(0.5f);
+	float Radius = B.Sub(A).Length() * 0.5f;
+	for (uint32 Index = 0; Index < NumVertices; ++Index)
+	{
+		const FVector3 Delta = Vertices[Index].Pos.Sub(Center);
+		const float Distance = Delta.Length();
+		if (Distance > Radius)
+		{
+			const float NewRadius = (Radius + Distance) * 0.5f;
+			Center = Center.Add(Delta.Mul((NewRadius - Radius) / Distance));
+			Radius = NewRadius;
+		}
+	}
+
+	const FVector3 BoxCenter = Bounds.Box.GetCenter();
+	float BoxRadiusSquared = 0;
+	for (uint32 Index = 0; Index < NumVertices; ++Index)
+	{
+		const FVector3 Delta = Vertices[Index].Pos.Sub(BoxCenter);
+		BoxRadiusSquared = max(BoxRadiusSquared, Delta.Dot(Delta));
+	}
+
+	const float BoxRadius = sqrt(BoxRadiusSquared);
+	if (BoxRadius < Radius)
+	{
+		Center = BoxCenter;
+		Radius = BoxRadius;
+	}
+
+	Bounds.Sphere.Center = Center;
+	Bounds.Sphere.Radius = Radius;
+	return Bounds;
+}
+
+void FCullBounds::Clear()
+{
+	CenterX.clear();
+	CenterY.clear();
+	CenterZ.clear();
+	ExtentX.clear();
+	ExtentY.clear();
+	ExtentZ.clear();
+	Radius.clear();
+	Num = 0;
+}
+
+void FCullBounds::Reserve(uint32 NumBounds)
+{
+	const uint32 NumPadded = (NumBounds + 3) & ~3;
+	CenterX.reserve(NumPadded);
+	CenterY.reserve(NumPadded);
+	CenterZ.reserve(NumPadded);
+	ExtentX.reserve(NumPadded);
+	ExtentY.reserve(NumPadded);
+	ExtentZ.reserve(NumPadded);
+	Radius.reserve(NumPadded);
+}
+
+uint32 FCullBounds::Add(const FBox& Box)
+{
+	if ((Num & 3) == 0)
+	{
+		// Negative sizes are outside of every plane
+		const uint32 NumPadded = Num + 4;
+		CenterX.resize(NumPadded, 0.0f);
+		CenterY.resize(NumPadded, 0.0f);
+		CenterZ.resize(NumPadded, 0.0f);
+		ExtentX.resize(NumPadded, -1e30f);
+		ExtentY.resize(NumPadded, -1e30f);
+		ExtentZ.resize(NumPadded, -1e30f);
+		Radius.resize(NumPadded, -1e30f);
+	}
+
+	Set(Num, Box);
+	return Num++;
+}
+
+uint32 FCullBounds::Add(const FSphere& Sphere)
+{
+	const uint32 Index = Add(FBox::GetEmpty());
+	Set(Index, Sphere);
+	return Index;
+}
+
+void FCullBounds::Set(uint32 Index, const FBox& Box)
+{
+	const FVector3 Center = Box.GetCenter();
+	const FVector3 Extent = Box.GetExtent();
+	CenterX[Index] = Center.x;
+	CenterY[Index] = Center.y;
+	CenterZ[Index] = Center.z;
+	ExtentX[Index] = Extent.x;
+	ExtentY[Index] = Extent.y;
+	ExtentZ[Index] = Extent.z;
+	Radius[Index] = Extent.Length();
+}
+
+void FCullBounds::Set(uint32 Index, const FSphere& Sphere)
+{
+	CenterX[Index] = Sphere.Center.x;
+	CenterY[Index] = Sphere.Center.y;
+	CenterZ[Index] = Sphere.Center.z;
+	ExtentX[Index] = Sphere.Radius;
+	ExtentY[Index] = Sphere.Radius;
+	ExtentZ[Index] = Sphere.Radius;
+	Radius[Index] = Sphere.Radius;
+}
+
+// Shared by CullBoxes() and CullSpheres(); a box's radius along a plane's normal is Dot(Extent, Abs(Normal))
+template <bool bBoxes>
+static void CullBounds(const FFrustum& Frustum, const FCullBounds& Bounds, std::vector<uint32>& OutVisible)
+{
+	// Written 4 at a time whether visible or not, then trimmed
+	OutVisible.resize((Bounds.Num + 3) & ~3);
+	uint32* Out = OutVisible.data();
+	uint32 NumVisible = 0;
+#if ENABLE_SIMD
+	__m128 PlaneX[6], PlaneY[6], PlaneZ[6], PlaneW[6];
+	__m128 AbsPlaneX[6], AbsPlaneY[6], AbsPlaneZ[6];
+	for (uint32 PlaneIndex = 0; PlaneIndex < 6; ++PlaneIndex)
+	{
+		const FVector4& Plane = Frustum.Planes[PlaneIndex];
+		PlaneX[PlaneIndex] = _mm_set1_ps(Plane.x);
+		PlaneY[PlaneIndex] = _mm_set1_ps(Plane.y);
+		PlaneZ[PlaneIndex] = _mm_set1_ps(Plane.z);
+		PlaneW[PlaneIndex] = _mm_set1_ps(Plane.w);
+		AbsPlaneX[PlaneIndex] = _mm_set1_ps(fabs(Plane.x));
+		AbsPlaneY[PlaneIndex] = _mm_set1_ps(fabs(Plane.y));
+		AbsPlaneZ[PlaneIndex] = _mm_set1_ps(fabs(Plane.z));
+	}
+
+	const __m128 Zero = _mm_setzero_ps();
+	for (uint32 Index = 0; Index < Bounds.Num; Index += 4)
+	{
+		const __m128 CenterX = _mm_loadu_ps(&Bounds.CenterX[Index]);
+		const __m128 CenterY = _mm_loadu_ps(&Bounds.CenterY[Index]);
+		const __m128 CenterZ = _mm_loadu_ps(&Bounds.CenterZ[Index]);
+		__m128 ExtentX, ExtentY, ExtentZ, Radius;
+		if (bBoxes)
+		{
+			ExtentX = _mm_loadu_ps(&Bounds.ExtentX[Index]);
+			ExtentY = _mm_loadu_ps(&Bounds.ExtentY[Index]);
+			ExtentZ = _mm_loadu_ps(&Bounds.ExtentZ[Index]);
+		}
+		else
+		{
+			Radius = _mm_loadu_ps(&Bounds.Radius[Index]);
+		}
+
+		// Lanes get set once outside of any plane
+		__m128 bOutside = _mm_setzero_ps();
+		for (uint32 PlaneIndex = 0; PlaneIndex < 6; ++PlaneIndex)
+		{
+			__m128 Distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(CenterX, PlaneX[PlaneIndex]), _mm_mul_ps(CenterY, PlaneY[PlaneIndex])),
+				_mm_add_ps(_mm_mul_ps(CenterZ, PlaneZ[PlaneIndex]), PlaneW[PlaneIndex]));
+			if (bBoxes)
+			{
+				Radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ExtentX, AbsPlaneX[PlaneIndex]), _mm_mul_ps(ExtentY, AbsPlaneY[PlaneIndex])), _mm_mul_ps(ExtentZ, AbsPlaneZ[PlaneIndex]));
+			}
+			bOutside = _mm_or_ps(bOutside, _mm_cmplt_ps(_mm_add_ps(Distance, Radius), Zero));
+		}
+
+		const int32 Mask = ~_mm_movemask_ps(bOutside);
+		for (uint32 Lane = 0; Lane < 4; ++Lane)
+		{
+			Out[NumVisible] = Index + Lane;
+			NumVisible += (Mask >> Lane) & 1;
+		}
+	}
+#else
+	for (uint32 Index = 0; Index < Bounds.Num; ++Index)
+	{
+		bool bVisible = true;
+		for (auto& Plane : Frustum.Planes)
+		{
+			const float Distance = Plane.x * Bounds.CenterX[Index] + Plane.y * Bounds.CenterY[Index] + Plane.z * Bounds.CenterZ[Index] + Plane.w;
+			const float Radius = bBoxes ? Bounds.ExtentX[Index] * fabs(Plane.x) + Bounds.ExtentY[Index] * fabs(Plane.y) + Bounds.ExtentZ[Index] * fabs(Plane.z) : Bounds.Radius[Index];
+			if (Distance + Radius < 0)
+			{
+				bVisible = false;
+				break;
+			}
+		}
+		Out[NumVisible] = Index;
+		NumVisible += bVisible ? 1 : 0;
+	}
+#endif
+	OutVisible.resize(NumVisible);
+}
+
+void CullBoxes(const FFrustum& Frustum, const FCullBounds& Bounds, std::vector<uint32>& OutVisible)
+{
+	CullBounds<true>(Frustum, Bounds, OutVisible);
+}
+
+void CullSpheres(const FFrustum& Frustum, const FCullBounds& Bounds, std::vector<uint32>& OutVisible)
+{
+	CullBounds<false>(Frustum, Bounds, OutVisible);
+}
+
+// Sum of weighted squared distances to a set of planes (Garland, Heckbert - "Surface Simplification Using Quadric Error Metrics")
+struct FQuadric
+{
+	double A00, A01, A02, A11, A12, A22;
+	double B0, B1, B2;
+	double C;
+	double Weight;
+
+	void AddPlane(const FVector3& Normal, float Distance, double PlaneWeight)
+	{
+		const double X = Normal.x;
+		const double Y = Normal.y;
+		const double Z = Normal.z;
+		A00 += X * X * PlaneWeight;
+		A01 += X * Y * PlaneWeight;
+		A02 += X * Z * PlaneWeight;
+		A11 += Y * Y * PlaneWeight;
+		A12 += Y * Z * PlaneWeight;
+		A22 += Z * Z * PlaneWeight;
+		B0 += X * Distance * PlaneWeight;
+		B1 += Y * Distance * PlaneWeight;
+		B2 += Z * Distance * PlaneWeight;
+		C += (double)Distance * Distance * PlaneWeight;
+		Weight += PlaneWeight;
+	}
+
+	void Add(const FQuadric& Q)
+	{
+		A00 += Q.A00;
+		A01 += Q.A01;
+		A02 += Q.A02;
+		A11 += Q.A11;
+		A12 += Q.A12;
+		A22 += Q.A22;
+		B0 += Q.B0;
+		B1 += Q.B1;
+		B2 += Q.B2;
+		C += Q.C;
+		Weight += Q.Weight;
+	}
+
+	// Mean squared distance from P to the planes
+	double Evaluate(const FVector3& P) const
+	{
+		const double X = P.x;
+		const double Y = P.y;
+		const double Z = P.z;
+		double Error = A00 * X * X + A11 * Y * Y + A22 * Z * Z + 2 * (A01 * X * Y + A02 * X * Z + A12 * Y * Z) + 2 * (B0 * X + B1 * Y + B2 * Z) + C;
+		return Weight > 0 ? max(Error, 0.0) / Weight : 0.0;
+	}
+};
+
+// Simplifies a triangle list in place down to about TargetNumIndices and returns the largest collapse error as a distance.
+// GlobalToLocal must be Vertices.size() entries of -1 and is left that way.
+static float SimplifyTriangles(const std::vector<FMeshVertex>& Vertices, std::vector<uint32>& Indices, uint32 TargetNumIndices, float AttributeWeight, std::vector<uint32>& GlobalToLocal)
+{
+	// Work on a compact local numbering of the vertices used
+	std::vector<uint32> LocalToGlobal;
+	std::vector<uint32> Triangles(Indices.size());
+	for (uint32 Index = 0; Index < (uint32)Indices.size(); ++Index)
+	{
+		uint32& Local = GlobalToLocal[Indices[Index]];
+		if (Local == (uint32)-1)
+		{
+			Local = (uint32)LocalToGlobal.size();
+			LocalToGlobal.push_back(Indices[Index]);
+		}
+		Triangles[Index] = Local;
+	}
+
+	const uint32 NumVertices = (uint32)LocalToGlobal.size();
+	auto GetVertex = [&](uint32 Local) -> const FMeshVertex&
+	{
+		return Vertices[LocalToGlobal[Local]];
+	};
+
+	// Area weighted plane quadrics
+	std::vector<FQuadric> Quadrics(NumVertices);
+	memset(Quadrics.data(), 0, Quadrics.size() * sizeof(FQuadric));
+	for (uint32 Index = 0; Index < (uint32)Triangles.size(); Index += 3)
+	{
+		const FVector3& A = GetVertex(Triangles[Index + 0]).Pos;
+		const FVector3& B = GetVertex(Triangles[Index + 1]).Pos;
+		const FVector3& C = GetVertex(Triangles[Index + 2]).Pos;
+		FVector3 Normal = B.Sub(A).Cross(C.Sub(A));
+		float DoubleArea = Normal.Length();
+		if (DoubleArea > 0)
+		{
+			Normal = Normal.Mul(1.0f / DoubleArea);
+			for (uint32 Corner = 0; Corner < 3; ++Corner)
+			{
+				Quadrics[Triangles[Index + Corner]].AddPlane(Normal, -Normal.Dot(A), DoubleArea * 0.5);
+			}
+		}
+	}
+
+	std::vector<uint32> AdjacencyOffsets;
+	std::vector<uint32> Adjacency;
+	std::vector<bool> bLocked;
+	std::vector<bool> bTouched;
+	std::vector<uint32> CollapseTarget;
+	std::vector<float> CollapseCost;
+	std::vector<float> CollapsePosCost;
+	std::vector<std::pair<float, uint32>> Candidates;
+	std::vector<uint32> Remap(NumVertices);
+	double MaxError = 0;
+
+	while (Triangles.size() > TargetNumIndices)
+	{
+		const uint32 NumTriangles = (uint32)Triangles.size() / 3;
+
+		// Vertex -> triangles
+		AdjacencyOffsets.assign(NumVertices + 1, 0);
+		for (uint32 Vertex : Triangles)
+		{
+			++AdjacencyOffsets[Vertex + 1];
+		}
+		for (uint32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+		{
+			AdjacencyOffsets[Vertex + 1] += AdjacencyOffsets[Vertex];
+		}
+		Adjacency.resize(Triangles.size());
+		{
+			std::vector<uint32> Fill(AdjacencyOffsets.begin(), AdjacencyOffsets.end() - 1);
+			for (uint32 Index = 0; Index < (uint32)Triangles.size(); ++Index)
+			{
+				Adjacency[Fill[Triangles[Index]]++] = Index / 3;
+			}
+		}
+
+		// An edge without its opposite half edge is a border (mesh border, seam or material boundary); lock both ends
+		bLocked.assign(NumVertices, false);
+		for (uint32 Triangle = 0; Triangle < NumTriangles; ++Triangle)
+		{
+			for (uint32 Corner = 0; Corner < 3; ++Corner)
+			{
+				const uint32 A = Triangles[Triangle * 3 + Corner];
+				const uint32 B = Triangles[Triangle * 3 + (Corner + 1) % 3];
+				bool bFound = false;
+				for (uint32 Adj = AdjacencyOffsets[B]; Adj < AdjacencyOffsets[B + 1] && !bFound; ++Adj)
+				{
+					const uint32* Other = &Triangles[Adjacency[Adj] * 3];
+					for (uint32 OtherCorner = 0; OtherCorner < 3; ++OtherCorner)
+					{
+						if (Other[OtherCorner] == B && Other[(OtherCorner + 1) % 3] == A)
+						{
+							bFound = true;
+							break;
+						}
+					}
+				}
+
+				if (!bFound)
+				{
+					bLocked[A] = true;
+					bLocked[B] = true;
+				}
+			}
+		}
+
+		// Cheapest collapse of every free vertex along one of its edges
+		CollapseTarget.assign(NumVertices, (uint32)-1);
+		CollapseCost.assign(NumVertices, FLT_MAX);
+		CollapsePosCost.assign(NumVertices, 0);
+		for (uint32 Index = 0; Index < (uint32)Triangles.size(); ++Index)
+		{
+			const uint32 Vertex = Triangles[Index];
+			if (bLocked[Vertex])
+			{
+				continue;
+			}
+
+			const uint32 First = Index - Index % 3;
+			for (uint32 Other = 1; Other < 3; ++Other)
+			{
+				const uint32 Target = Triangles[First + (Index - First + Other) % 3];
+				const FMeshVertex& From = GetVertex(Vertex);
+				const FMeshVertex& To = GetVertex(Target);
+				const float PosCost = (float)Quadrics[Vertex].Evaluate(To.Pos);
+
+				// Attribute differences, scaled by the edge length to stay in squared distance units
+				FVector3 DeltaNormal = From.Normal.Sub(To.Normal);
+				FVector3 DeltaPos = From.Pos.Sub(To.Pos);
+				const float DeltaU = From.UV.u - To.UV.u;
+				const float DeltaV = From.UV.v - To.UV.v;
+				const float AttributeCost = AttributeWeight * (DeltaNormal.Dot(DeltaNormal) + DeltaU * DeltaU + DeltaV * DeltaV) * DeltaPos.Dot(DeltaPos);
+				if (PosCost + AttributeCost < CollapseCost[Vertex])
+				{
+					CollapseCost[Vertex] = PosCost + AttributeCost;
+					CollapsePosCost[Vertex] = PosCost;
+					CollapseTarget[Vertex] = Target;
+				}
+			}
+		}
+
+		Candidates.clear();
+		for (uint32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+		{
+			if (CollapseTarget[Vertex] != (uint32)-1)
+			{
+				Candidates.push_back(std::make_pair(CollapseCost[Vertex], Vertex));
+			}
+		}
+		std::sort(Candidates.begin(), Candidates.end());
+
+		// Collapse cheapest first; a collapse freezes the vertices around it until the next pass
+		for (uint32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+		{
+			Remap[Vertex] = Vertex;
+		}
+		bTouched.assign(NumVertices, false);
+		uint32 NumTrianglesLeft = NumTriangles;
+		uint32 NumCollapses = 0;
+		for (auto& Candidate : Candidates)
+		{
+			const uint32 Vertex = Candidate.second;
+			const uint32 Target = CollapseTarget[Vertex];
+			if (bTouched[Vertex] || bTouched[Target])
+			{
+				continue;
+			}
+
+			// Reject collapses that flip or badly rotate a remaining triangle
+			const FVector3& NewPos = GetVertex(Target).Pos;
+			bool bFlips = false;
+			uint32 NumRemoved = 0;
+			for (uint32 Adj = AdjacencyOffsets[Vertex]; Adj < AdjacencyOffsets[Vertex + 1] && !bFlips; ++Adj)
+			{
+				const uint32* Triangle = &Triangles[Adjacency[Adj] * 3];
+				if (Triangle[0] == Target || Triangle[1] == Target || Triangle[2] == Target)
+				{
+					++NumRemoved;
+					continue;
+				}
+
+				const uint32 Corner = Triangle[0] == Vertex ? 0 : (Triangle[1] == Vertex ? 1 : 2);
+				const FVector3& B = GetVertex(Triangle[(Corner + 1) % 3]).Pos;
+				const FVector3& C = GetVertex(Triangle[(Corner + 2) % 3]).Pos;
+				FVector3 Before = B.Sub(GetVertex(Vertex).Pos).Cross(C.Sub(GetVertex(Vertex).Pos));
+				FVector3 After = B.Sub(NewPos).Cross(C.Sub(NewPos));
+				bFlips = Before.Dot(After) <= 0.25f * Before.Length() * After.Length();
+			}
+
+			if (bFlips)
+			{
+				continue;
+			}
+
+			Remap[Vertex] = Target;
+			Quadrics[Target].Add(Quadrics[Vertex]);
+			MaxError = max(MaxError, (double)CollapsePosCost[Vertex]);
+			for (uint32 Adj = AdjacencyOffsets[Vertex]; Adj < AdjacencyOffsets[Vertex + 1]; ++Adj)
+			{
+				const uint32* Triangle = &Triangles[Adjacency[Adj] * 3];
+				bTouched[Triangle[0]] = true;
+				bTouched[Triangle[1]] = true;
+				bTouched[Triangle[2]] = true;
+			}
+
+			++NumCollapses;
+			NumTrianglesLeft -= NumRemoved;
+			if (NumTrianglesLeft * 3 <= TargetNumIndices)
+			{
+				break;
+			}
+		}
+
+		if (NumCollapses == 0)
+		{
+			break;
+		}
+
+		// Remap and drop the triangles that collapsed
+		uint32 NumIndices = 0;
+		for (uint32 Index = 0; Index < (uint32)Triangles.size(); Index += 3)
+		{
+			const uint32 A = Remap[Triangles[Index + 0]];
+			const uint32 B = Remap[Triangles[Index + 1]];
+			const uint32 C = Remap[Triangles[Index + 2]];
+			if (A != B && B != C && A != C)
+			{
+				Triangles[NumIndices++] = A;
+				Triangles[NumIndices++] = B;
+				Triangles[NumIndices++] = C;
+			}
+		}
+		Triangles.resize(NumIndices);
+	}
+
+	Indices.resize(Triangles.size());
+	for (uint32 Index = 0; Index < (uint32)Triangles.size(); ++Index)
+	{
+		Indices[Index] = LocalToGlobal[Triangles[Index]];
+	}
+
+	for (uint32 Global : LocalToGlobal)
+	{
+		GlobalToLocal[Global] = (uint32)-1;
+	}
+
+	return (float)sqrt(MaxError);
+}
+
+void BuildLodChain(FIndexedMesh& Mesh, const float* Ratios, uint32 NumRatios, float AttributeWeight)
+{
+	if (Mesh.Sections.empty())
+	{
+		FMeshSection Section = {0, 0, (uint32)Mesh.Indices.size(), 0, 0};
+		Mesh.Sections.push_back(Section);
+	}
+	check(Mesh.GetNumLods() == 1);
+
+	// Each level simplifies every section of the previous one separately, so materials never mix
+	const std::vector<FMeshSection> Lod0Sections = Mesh.Sections;
+	std::vector<std::vector<uint32>> SectionIndices(Lod0Sections.size());
+	uint32 PreviousNumIndices = 0;
+	for (uint32 Index = 0; Index < (uint32)Lod0Sections.size(); ++Index)
+	{
+		const FMeshSection& Section = Lod0Sections[Index];
+		SectionIndices[Index].assign(Mesh.Indices.begin() + Section.FirstIndex, Mesh.Indices.begin() + Section.FirstIndex + Section.NumIndices);
+		PreviousNumIndices += Section.NumIndices;
+	}
+
+	std::vector<uint32> GlobalToLocal(Mesh.Vertices.size(), (uint32)-1);
+	float PreviousError = 0;
+	for (uint32 Lod = 1; Lod <= NumRatios; ++Lod)
+	{
+		float Error = 0;
+		uint32 NumIndices = 0;
+		for (uint32 Index = 0; Index < (uint32)Lod0Sections.size(); ++Index)
+		{
+			const uint32 Target = (uint32)(Lod0Sections[Index].NumIndices / 3 * Ratios[Lod - 1]) * 3;
+			const float SectionError = SimplifyTriangles(Mesh.Vertices, SectionIndices[Index], Target, AttributeWeight, GlobalToLocal);
+			Error = max(Error, SectionError);
+			NumIndices += (uint32)SectionIndices[Index].size();
+		}
+
+		if (NumIndices > PreviousNumIndices * 9 / 10)
+		{
+			break;
+		}
+
+		// Errors are measured against the previous level, so they add up
+		PreviousError += Error;
+		PreviousNumIndices = NumIndices;
+		for (uint32 Index = 0; Index < (uint32)Lod0Sections.size(); ++Index)
+		{
+			if (!SectionIndices[Index].empty())
+			{
+				FMeshSection Section = {Lod0Sections[Index].Material, (uint32)Mesh.Indices.size(), (uint32)SectionIndices[Index].size(), Lod, PreviousError};
+				Mesh.Sections.push_back(Section);
+				Mesh.Indices.insert(Mesh.Indices.end(), SectionIndices[Index].begin(), SectionIndices[Index].end());
+			}
+		}
+	}
+}
+
+uint32 SelectLod(const FMeshSection* Sections, uint32 NumSections, float Distance, float ProjectionScale, float MaxPixelError)
+{
+	const float MaxError = MaxPixelError * max(Distance, 0.0f) / ProjectionScale;
+	uint32 Lod = 0;
+	for (uint32 Index = 0; Index < NumSections; ++Index)
+	{
+		if (Sections[Index].LodError <= MaxError)
+		{
+			Lod = max(Lod, Sections[Index].Lod);
+		}
+	}
+	return Lod;
+}
+
+FVertexQuantization ComputeVertexQuantization(const FMeshVertex* Vertices, uint32 NumVertices)
+{
+	if (NumVertices == 0)
+	{
+		return FVertexQuantization::GetIdentity();
+	}
+
+	FBox Box = FBox::GetEmpty();
+	for (uint32 Index = 0; Index < NumVertices; ++Index)
+	{
+		Box.Add(Vertices[Index].Pos);
+	}
+
+	FVertexQuantization Quantization;
+	Quantization.Scale = Box.Max.Sub(Box.Min);
+	Quantization.Bias = Box.Min;
+	return Quantization;
+}
+
+// 65535 steps per unit of Scale, or 0 on a flat axis
+static FVector3 GetQuantizationInvScale(const FVertexQuantization& Quantization)
+{
+	FVector3 InvScale;
+	for (uint32 Axis = 0; Axis < 3; ++Axis)
+	{
+		InvScale.Values[Axis] = Quantization.Scale.Values[Axis] > 0 ? 65535.0f / Quantization.Scale.Values[Axis] : 0;
+	}
+	return InvScale;
+}
+
+// Position and uv of one vertex, shared by FQuantizedVertex and FQuantizedTangentVertex
+static inline void QuantizePosAndUV(const FMeshVertex& In, const FVertexQuantization& Quantization, const FVector3& InvScale, uint16 OutPos[3], uint16 OutUV[2])
+{
+	for (uint32 Axis = 0; Axis < 3; ++Axis)
+	{
+		const float Unorm = (In.Pos.Values[Axis] - Quantization.Bias.Values[Axis]) * InvScale.Values[Axis];
+		OutPos[Axis] = (uint16)(min(max(Unorm, 0.0f), 65535.0f) + 0.5f);
+	}
+
+	OutUV[0] = FloatToHalf(In.UV.u);
+	OutUV[1] = FloatToHalf(In.UV.v);
+}
+
+void QuantizeVertices(const FMeshVertex* Vertices, uint32 NumVertices, const FVertexQuantization& Quantization, FQuantizedVertex* OutVertices)
+{
+	const FVector3 InvScale = GetQuantizationInvScale(Quantization);
+	for (uint32 Index = 0; Index < NumVertices; ++Index)
+	{
+		QuantizePosAndUV(Vertices[Index], Quantization, InvScale, OutVertices[Index].Pos, OutVertices[Index].UV);
+	}
+
+	EncodeNormalsOctahedral8(&Vertices[0].Normal, sizeof(FMeshVertex), NumVertices, &OutVertices[0].Normal, sizeof(FQuantizedVertex));
+}
+
+void QuantizeVertices(const FIndexedMesh& Mesh, const FVertexQuantization& Quantization, FQuantizedTangentVertex* OutVertices)
+{
+	check(Mesh.Tangents.size() == Mesh.Vertices.size());
+
+	const FVector3 InvScale = GetQuantizationInvScale(Quantization);
+	for (uint32 Index = 0; Index < (uint32)Mesh.Vertices.size(); ++Index)
+	{
+		const FMeshVertex& In = Mesh.Vertices[Index];
+		FQuantizedTangentVertex& Out = OutVertices[Index];
+		QuantizePosAndUV(In, Quantization, InvScale, Out.Pos, Out.UV);
+		Out.Padding = 0;
+		Out.TangentFrame = EncodeTangentFrame(In.Normal, Mesh.Tangents[Index]);
+	}
+}
+
+FMeshVertex DequantizeVertex(const FQuantizedVertex& Vertex, const FVertexQuantization& Quantization)
+{
+	FMeshVertex Out;
+	for (uint32 Axis = 0; Axis < 3; ++Axis)
+	{
+		Out.Pos.Values[Axis] = Vertex.Pos[Axis] / 65535.0f * Quantization.Scale.Values[Axis] + Quantization.Bias.Values[Axis];
+	}
+
+	Out.Normal = DecodeOctahedral8(Vertex.Normal);
+	Out.UV.u = HalfToFloat(Vertex.UV[0]);
+	Out.UV.v = HalfToFloat(Vertex.UV[1]);
+	return Out;
+}
+
+#if ENABLE_SIMD
+// Loads 4 normals Stride bytes apart as x, y, z vectors. The first three read 4 bytes past their z, which is still
+// inside the next normal; the last one reads exactly its 12 bytes so the last group of an array can be loaded too.
+static inline void LoadNormals4(const FVector3* Normals, uint32 Stride, __m128& OutX, __m128& OutY, __m128& OutZ)
+{
+	const char* Ptr = (const char*)Normals;
+	__m128 N0 = _mm_loadu_ps((const float*)(Ptr + 0 * Stride));
+	__m128 N1 = _mm_loadu_ps((const float*)(Ptr + 1 * Stride));
+	__m128 N2 = _mm_loadu_ps((const float*)(Ptr + 2 * Stride));
+	__m128 N3 = _mm_movelh_ps(_mm_castpd_ps(_mm_load_sd((const double*)(Ptr + 3 * Stride))), _mm_load_ss((const float*)(Ptr + 3 * Stride) + 2));
+	_MM_TRANSPOSE4_PS(N0, N1, N2, N3);
+	OutX = N0;
+	OutY = N1;
+	OutZ = N2;
+}
+
+// Same as EncodeOctahedral() then FloatToSnorm*() on 4 normals; Scale is 32767 or 127
+static inline void EncodeOctahedral4(__m128 X, __m128 Y, __m128 Z, __m128 Scale, __m128i& OutX, __m128i& OutY)
+{
+	const __m128 SignMask = _mm_set1_ps(-0.0f);
+	const __m128 Zero = _mm_setzero_ps();
+	const __m128 One = _mm_set1_ps(1.0f);
+	const __m128 Half = _mm_set1_ps(0.5f);
+
+	const __m128 L1 = _mm_add_ps(_mm_add_ps(_mm_andnot_ps(SignMask, X), _mm_andnot_ps(SignMask, Y)), _mm_andnot_ps(SignMask, Z));
+	const __m128 bValid = _mm_cmpgt_ps(L1, Zero);
+	__m128 EX = _mm_and_ps(_mm_div_ps(X, L1), bValid);
+	__m128 EY = _mm_and_ps(_mm_div_ps(Y, L1), bValid);
+
+	// Fold the lower hemisphere over the diagonals
+	const __m128 FoldX = _mm_or_ps(_mm_sub_ps(One, _mm_andnot_ps(SignMask, EY)), _mm_and_ps(_mm_cmplt_ps(EX, Zero), SignMask));
+	const __m128 FoldY = _mm_or_ps(_mm_sub_ps(One, _mm_andnot_ps(SignMask, EX)), _mm_and_ps(_mm_cmplt_ps(EY, Zero), SignMask));
+	const __m128 bLower = _mm_cmplt_ps(Z, Zero);
+	EX = _mm_or_ps(_mm_and_ps(bLower, FoldX), _mm_andnot_ps(bLower, EX));
+	EY = _mm_or_ps(_mm_and_ps(bLower, FoldY), _mm_andnot_ps(bLower, EY));
+
+	// Clamp, scale and round half away from zero
+	EX = _mm_min_ps(_mm_max_ps(EX, _mm_sub_ps(Zero, One)), One);
+	EY = _mm_min_ps(_mm_max_ps(EY, _mm_sub_ps(Zero, One)), One);
+	const __m128 RoundX = _mm_or_ps(Half, _mm_and_ps(_mm_cmplt_ps(EX, Zero), SignMask));
+	const __m128 RoundY = _mm_or_ps(Half, _mm_and_ps(_mm_cmplt_ps(EY, Zero), SignMask));
+	OutX = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(EX, Scale), RoundX));
+	OutY = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(EY, Scale), RoundY));
+}
+#endif
+
+void PackNormalsToU32(const FVector3* Normals, uint32 Stride, uint32 NumNormals, uint32* Out, uint32 OutStride)
+{
+	uint32 Index = 0;
+#if ENABLE_SIMD
+	const __m128 One = _mm_set1_ps(1.0f);
+	const __m128 Scale = _mm_set1_ps(127.5f);
+	const __m128i ByteMask = _mm_set1_epi32(0xff);
+	for (; Index + 4 <= NumNormals; Index += 4)
+	{
+		__m128 X, Y, Z;
+		LoadNormals4((const FVector3*)((const char*)Normals + Index * Stride), Stride, X, Y, Z);
+		__m128i PackedX = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(X, One), Scale)), ByteMask);
+		__m128i PackedY = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(Y, One), Scale)), ByteMask);
+		__m128i PackedZ = _mm_and_si128(_mm_cvttps_epi32(_mm_mul_ps(_mm_add_ps(Z, One), Scale)), ByteMask);
+		__m128i Packed = _mm_or_si128(PackedX, _mm_or_si128(_mm_slli_epi32(PackedY, 8), _mm_slli_epi32(PackedZ, 16)));
+
+		alignas(16) uint32 Values[4];
+		_mm_store_si128((__m128i*)Values, Packed);
+		for (uint32 Lane = 0; Lane < 4; ++Lane)
+		{
+			*(uint32*)((char*)Out + (Index + Lane) * OutStride) = Values[Lane];
+		}
+	}
+#endif
+	for (; Index < NumNormals; ++Index)
+	{
+		*(uint32*)((char*)Out + Index * OutStride) = PackNormalToU32(*(const FVector3*)((const char*)Normals + Index * Stride));
+	}
+}
+
+void EncodeNormalsOctahedral16(const FVector3* Normals, uint32 Stride, uint32 NumNormals, uint32* Out, uint32 OutStride)
+{
+	uint32 Index = 0;
+#if ENABLE_SIMD
+	const __m128 Scale = _mm_set1_ps(32767.0f);
+	const __m128i LowMask = _mm_set1_epi32(0xffff);
+	for (; Index + 4 <= NumNormals; Index += 4)
+	{
+		__m128 X, Y, Z;
+		LoadNormals4((const FVector3*)((const char*)Normals + Index * Stride), Stride, X, Y, Z);
+		__m128i EX, EY;
+		EncodeOctahedral4(X, Y, Z, Scale, EX, EY);
+		__m128i Packed = _mm_or_si128(_mm_and_si128(EX, LowMask), _mm_slli_epi32(EY, 16));
+
+		alignas(16) uint32 Values[4];
+		_mm_store_si128((__m128i*)Values, Packed);
+		for (uint32 Lane = 0; Lane < 4; ++Lane)
+		{
+			*(uint32*)((char*)Out + (Index + Lane) * OutStride) = Values[Lane];
+		}
+	}
+#endif
+	for (; Index < NumNormals; ++Index)
+	{
+		*(uint32*)((char*)Out + Index * OutStride) = EncodeOctahedral16(*(const FVector3*)((const char*)Normals + Index * Stride));
+	}
+}
+
+void EncodeNormalsOctahedral8(const FVector3* Normals, uint32 Stride, uint32 NumNormals, uint16* Out, uint32 OutStride)
+{
+	uint32 Index = 0;
+#if ENABLE_SIMD
+	const __m128 Scale = _mm_set1_ps(127.0f);
+	const __m128i LowMask = _mm_set1_epi32(0xff);
+	for (; Index + 4 <= NumNormals; Index += 4)
+	{
+		__m128 X, Y, Z;
+		LoadNormals4((const FVector3*)((const char*)Normals + Index * Stride), Stride, X, Y, Z);
+		__m128i EX, EY;
+		EncodeOctahedral4(X, Y, Z, Scale, EX, EY);
+		__m128i Packed = _mm_or_si128(_mm_and_si128(EX, LowMask), _mm_slli_epi32(_mm_and_si128(EY, LowMask), 8));
+
+		alignas(16) uint32 Values[4];
+		_mm_store_si128((__m128i*)Values, Packed);
+		for (uint32 Lane = 0; Lane < 4; ++Lane)
+		{
+			*(uint16*)((char*)Out + (Index + Lane) * OutStride) = (uint16)Values[Lane];
+		}
+	}
+#endif
+	for (; Index < NumNormals; ++Index)
+	{
+		*(uint16*)((char*)Out + Index * OutStride) = EncodeOctahedral8(*(const FVector3*)((const char*)Normals + Index * Stride));
+	}
+}
+
+// Any unit vector perpendicular to N
+static FVector3 GetPerpendicular(const FVector3& N)
+{
+	const FVector3 Axis = fabsf(N.x) < 0.9f ? FVector3({{{1, 0, 0}}}) : FVector3({{{0, 1, 0}}});
+	return Axis.Sub(N.Mul(N.Dot(Axis))).GetNormalized();
+}
+
+void ComputeTangents(FIndexedMesh& Mesh, uint32 NumThreads)
+{
+	NumThreads = NumThreads ? NumThreads : GetNumberOfCores();
+	const uint32 NumTriangles = Mesh.GetNumTriangles();
+	const uint32 NumVertices = (uint32)Mesh.Vertices.size();
+
+	// Unit tangent along increasing u of every face; w is 1 if the uvs keep the winding, -1 if mirrored, 0 if degenerate
+	std::vector<FVector4> FaceTangents(NumTriangles);
+	RunOnThreads(NumThreads,
+		[&](uint32 ThreadIndex)
+		{
+			const uint32 Begin = (uint32)((uint64)NumTriangles * ThreadIndex / NumThreads);
+			const uint32 End = (uint32)((uint64)NumTriangles * (ThreadIndex + 1) / NumThreads);
+			for (uint32 Triangle = Begin; Triangle < End; ++Triangle)
+			{
+				const FMeshVertex& V0 = Mesh.Vertices[Mesh.Indices[Triangle * 3 + 0]];
+				const FMeshVertex& V1 = Mesh.Vertices[Mesh.Indices[Triangle * 3 + 1]];
+				const FMeshVertex& V2 = Mesh.Vertices[Mesh.Indices[Triangle * 3 + 2]];
+				const FVector3 Edge1 = V1.Pos.Sub(V0.Pos);
+				const FVector3 Edge2 = V2.Pos.Sub(V0.Pos);
+				const float DeltaU1 = V1.UV.u - V0.UV.u;
+				const float DeltaV1 = V1.UV.v - V0.UV.v;
+				const float DeltaU2 = V2.UV.u - V0.UV.u;
+				const float DeltaV2 = V2.UV.v - V0.UV.v;
+				const float SignedUVArea = DeltaU1 * DeltaV2 - DeltaU2 * DeltaV1;
+				const FVector3 Tangent = Edge1.Mul(DeltaV2).Sub(Edge2.Mul(DeltaV1));
+				const float Length = Tangent.Length();
+
+				FVector4& Out = FaceTangents[Triangle];
+				if (SignedUVArea != 0 && Length > 0)
+				{
+					// Tangent is dP/du scaled by the signed uv area
+					Out.w = SignedUVArea > 0 ? 1.0f : -1.0f;
+					Out.x = Tangent.x / Length * Out.w;
+					Out.y = Tangent.y / Length * Out.w;
+					Out.z = Tangent.z / Length * Out.w;
+				}
+				else
+				{
+					Out = FVector4::GetZero();
+				}
+			}
+		});
+
+	// Vertex -> corners
+	std::vector<uint32> CornerOffsets(NumVertices + 1, 0);
+	for (uint32 Index : Mesh.Indices)
+	{
+		++CornerOffsets[Index + 1];
+	}
+	for (uint32 Vertex = 0; Vertex < NumVertices; ++Vertex)
+	{
+		CornerOffsets[Vertex + 1] += CornerOffsets[Vertex];
+	}
+	std::vector<uint32> Corners(Mesh.Indices.size());
+	{
+		std::vector<uint32> Fill(CornerOffsets.begin(), CornerOffsets.end() - 1);
+		for (uint32 Corner = 0; Corner < (uint32)Mesh.Indices.size(); ++Corner)
+		{
+			Corners[Fill[Mesh.Indices[Corner]]++] = Corner;
+		}
+	}
+
+	Mesh.Tangents.resize(NumVertices);
+	RunOnThreads(NumThreads,
+		[&](uint32 ThreadIndex)
+		{
+			const uint32 Begin = (uint32)((uint64)NumVertices * ThreadIndex / NumThreads);
+			const uint32 End = (uint32)((uint64)NumVertices * (ThreadIndex + 1) / NumThreads);
+			for (uint32 Vertex = Begin; Vertex < End; ++Vertex)
+			{
+				const FMeshVertex& V = Mesh.Vertices[Vertex];
+				FVector3 Normal = V.Normal.GetNormalized();
+				FVector3 Sum = FVector3::GetZero();
+				float SignSum = 0;
+				for (uint32 Adj = CornerOffsets[Vertex]; Adj < CornerOffsets[Vertex + 1]; ++Adj)
+				{
+					const uint32 Corner = Corners[Adj];
+					const uint32 Triangle = Corner / 3;
+					const FVector4& Face = FaceTangents[Triangle];
+					if (Face.w == 0)
+					{
+						continue;
+					}
+
+					// Angle between the two edges leaving this corner, in the normal's plane
+					const FVector3& Next = Mesh.Vertices[Mesh.Indices[Triangle * 3 + (Corner + 1) % 3]].Pos;
+					const FVector3& Prev = Mesh.Vertices[Mesh.Indices[Triangle * 3 + (Corner + 2) % 3]].Pos;
+					FVector3 EdgeA = Next.Sub(V.Pos);
+					FVector3 EdgeB = Prev.Sub(V.Pos);
+					EdgeA = EdgeA.Sub(Normal.Mul(Normal.Dot(EdgeA))).GetNormalized();
+					EdgeB = EdgeB.Sub(Normal.Mul(Normal.Dot(EdgeB))).GetNormalized();
+					const float Angle = acosf(min(max(EdgeA.Dot(EdgeB), -1.0f), 1.0f));
+
+					const FVector3 FaceTangent = {{{Face.x, Face.y, Face.z}}};
+					const FVector3 Projected = FaceTangent.Sub(Normal.Mul(Normal.Dot(FaceTangent))).GetNormalized();
+					Sum = Sum.Add(Projected.Mul(Angle));
+					SignSum += Face.w * Angle;
+				}
+
+				// Gram-Schmidt against the normal; no usable uvs gets any perpendicular tangent
+				FVector3 Tangent = Sum.Sub(Normal.Mul(Normal.Dot(Sum)));
+				Tangent = Tangent.Length() > 1e-12f ? Tangent.GetNormalized() : GetPerpendicular(Normal);
+
+				FVector4& Out = Mesh.Tangents[Vertex];
+				Out.x = Tangent.x;
+				Out.y = Tangent.y;
+				Out.z = Tangent.z;
+				Out.w = SignSum < 0 ? -1.0f : 1.0f;
+			}
+		});
+}
+
+#if ENABLE_SIMD
+// M's first three columns broadcast, for 4 positions at a time in x/y/z registers
+struct FTransformSimd
+{
+	__m128 M[4][3];
+
+	FTransformSimd(const FMatrix4x4& Matrix)
+	{
+		for (uint32 Row = 0; Row < 4; ++Row)
+		{
+			for (uint32 Column = 0; Column < 3; ++Column)
+			{
+				M[Row][Column] = _mm_set1_ps(Matrix.Values[Row * 4 + Column]);
+			}
+		}
+	}
+
+	__m128 Transform(uint32 Column, __m128 X, __m128 Y, __m128 Z) const
+	{
+		return _mm_add_ps(_mm_add_ps(_mm_mul_ps(X, M[0][Column]), _mm_mul_ps(Y, M[1][Column])), _mm_add_ps(_mm_mul_ps(Z, M[2][Column]), M[3][Column]));
+	}
+};
+
+struct FBoundsSimd
+{
+	__m128 Min[3];
+	__m128 Max[3];
+
+	FBoundsSimd()
+	{
+		for (uint32 Axis = 0; Axis < 3; ++Axis)
+		{
+			Min[Axis] = _mm_set1_ps(FLT_MAX);
+			Max[Axis] = _mm_set1_ps(-FLT_MAX);
+		}
+	}
+
+	void Add(__m128 X, __m128 Y, __m128 Z)
+	{
+		Min[0] = _mm_min_ps(Min[0], X);
+		Min[1] = _mm_min_ps(Min[1], Y);
+		Min[2] = _mm_min_ps(Min[2], Z);
+		Max[0] = _mm_max_ps(Max[0], X);
+		Max[1] = _mm_max_ps(Max[1], Y);
+		Max[2] = _mm_max_ps(Max[2], Z);
+	}
+
+	void AddTo(FBox& Box) const
+	{
+		float Mins[3][4];
+		float Maxs[3][4];
+		for (uint32 Axis = 0; Axis < 3; ++Axis)
+		{
+			_mm_storeu_ps(Mins[Axis], Min[Axis]);
+			_mm_storeu_ps(Maxs[Axis], Max[Axis]);
+		}
+		for (uint32 Lane = 0; Lane < 4; ++Lane)
+		{
+			if (Mins[0][Lane] > Maxs[0][Lane])
+			{
+				// Nothing added
+				continue;
+			}
+			Box.Add({{{Mins[0][Lane], Mins[1][Lane], Mins[2][Lane]}}});
+			Box.Add({{{Maxs[0][Lane], Maxs[1][Lane], Maxs[2][Lane]}}});
+		}
+	}
+};
+#endif
+
+static FVector3 TransformPosition(const FMatrix4x4& M, float X, float Y, float Z)
+{
+	FVector3 Out;
+	for (uint32 Column = 0; Column < 3; ++Column)
+	{
+		Out.Values[Column] = X * M.Values[0 * 4 + Column] + Y * M.Values[1 * 4 + Column] + Z * M.Values[2 * 4 + Column] + M.Values[3 * 4 + Column];
+	}
+	return Out;
+}
+
+// Splits [0, NumPositions) in runs of multiples of 4 (at least 16k positions each) and merges the threads' bounds
+template <typename TRangeFunction>
+static void TransformOnThreads(uint32 NumPositions, uint32 NumThreads, FBox* OutBounds, TRangeFunction RangeFunction)
+{
+	NumThreads = NumThreads ? NumThreads : GetNumberOfCores();
+	NumThreads = max(min(NumThreads, NumPositions / 16384), 1u);
+	std::vector<FBox> ThreadBounds(NumThreads, FBox::GetEmpty());
+	if (NumThreads == 1)
+	{
+		RangeFunction(0, NumPositions, ThreadBounds[0]);
+	}
+	else
+	{
+		RunOnThreads(NumThreads,
+			[&](uint32 ThreadIndex)
+			{
+				const uint32 Begin = (uint32)((uint64)NumPositions * ThreadIndex / NumThreads) & ~3u;
+				const uint32 End = ThreadIndex + 1 == NumThreads ? NumPositions : (uint32)((uint64)NumPositions * (ThreadIndex + 1) / NumThreads) & ~3u;
+				RangeFunction(Begin, End, ThreadBounds[ThreadIndex]);
+			});
+	}
+
+	if (OutBounds)
+	{
+		*OutBounds = FBox::GetEmpty();
+		for (auto& Bounds : ThreadBounds)
+		{
+			if (Bounds.IsValid())
+			{
+				OutBounds->Add(Bounds.Min);
+				OutBounds->Add(Bounds.Max);
+			}
+		}
+	}
+}
+
+void TransformPositions(const FMatrix4x4& M, const FVector3* In, uint32 Stride, uint32 NumPositions, FVector3* Out, uint32 OutStride, FBox* OutBounds, uint32 NumThreads)
+{
+	TransformOnThreads(NumPositions, NumThreads, OutBounds,
+		[=](uint32 Begin, uint32 End, FBox& Bounds)
+		{
+			// Copies so the compiler doesn't reload them after every store
+			const uint8* InBytes = (const uint8*)In;
+			uint8* OutBytes = (uint8*)Out;
+			uint32 Index = Begin;
+#if ENABLE_SIMD
+			// One position per register: x, y and z broadcast against M's rows, so only 12 bytes are stored as Out may be
+			// interleaved with other data
+			const __m128 Row0 = _mm_loadu_ps(M.Values + 0);
+			const __m128 Row1 = _mm_loadu_ps(M.Values + 4);
+			const __m128 Row2 = _mm_loadu_ps(M.Values + 8);
+			const __m128 Row3 = _mm_loadu_ps(M.Values + 12);
+			__m128 Min = _mm_set1_ps(FLT_MAX);
+			__m128 Max = _mm_set1_ps(-FLT_MAX);
+
+			// Positions are loaded as 16 bytes, so the array's last one is left for the scalar loop
+			const uint32 SimdEnd = min(End, NumPositions - 1);
+			for (; Index < SimdEnd; ++Index)
+			{
+				const __m128 Pos = _mm_loadu_ps((const float*)(InBytes + Index * Stride));
+				const __m128 NewPos = _mm_add_ps(_mm_add_ps(_mm_mul_ps(SIMD_SWIZZLE(Pos, 0, 0, 0, 0), Row0), _mm_mul_ps(SIMD_SWIZZLE(Pos, 1, 1, 1, 1), Row1)),
+					_mm_add_ps(_mm_mul_ps(SIMD_SWIZZLE(Pos, 2, 2, 2, 2), Row2), Row3));
+				float* Dest = (float*)(OutBytes + Index * OutStride);
+				_mm_storel_pi((__m64*)Dest, NewPos);
+				_mm_store_ss(Dest + 2, _mm_movehl_ps(NewPos, NewPos));
+				Min = _mm_min_ps(Min, NewPos);
+				Max = _mm_max_ps(Max, NewPos);
+			}
+
+			if (Index > Begin)
+			{
+				FVector4 BoundsMin;
+				FVector4 BoundsMax;
+				_mm_storeu_ps(BoundsMin.Values, Min);
+				_mm_storeu_ps(BoundsMax.Values, Max);
+				Bounds.Add({{{BoundsMin.x, BoundsMin.y, BoundsMin.z}}});
+				Bounds.Add({{{BoundsMax.x, BoundsMax.y, BoundsMax.z}}});
+			}
+#endif
+			for (; Index < End; ++Index)
+			{
+				const FVector3& Pos = *(const FVector3*)(InBytes + Index * Stride);
+				const FVector3 NewPos = TransformPosition(M, Pos.x, Pos.y, Pos.z);
+				*(FVector3*)(OutBytes + Index * OutStride) = NewPos;
+				Bounds.Add(NewPos);
+			}
+		});
+}
+
+void TransformPositions(const FMatrix4x4& M, const float* InX, const float* InY, const float* InZ, uint32 NumPositions, float* OutX, float* OutY, float* OutZ, FBox* OutBounds, uint32 NumThreads)
+{
+	TransformOnThreads(NumPositions, NumThreads, OutBounds,
+		[&](uint32 Begin, uint32 End, FBox& Bounds)
+		{
+			uint32 Index = Begin;
+#if ENABLE_SIMD
+			const FTransformSimd Transform(M);
+			FBoundsSimd BoundsSimd;
+			for (; Index + 4 <= End; Index += 4)
+			{
+				const __m128 X = _mm_loadu_ps(InX + Index);
+				const __m128 Y = _mm_loadu_ps(InY + Index);
+				const __m128 Z = _mm_loadu_ps(InZ + Index);
+				const __m128 NewX = Transform.Transform(0, X, Y, Z);
+				const __m128 NewY = Transform.Transform(1, X, Y, Z);
+				const __m128 NewZ = Transform.Transform(2, X, Y, Z);
+				_mm_storeu_ps(OutX + Index, NewX);
+				_mm_storeu_ps(OutY + Index, NewY);
+				_mm_storeu_ps(OutZ + Index, NewZ);
+				BoundsSimd.Add(NewX, NewY, NewZ);
+			}
+			BoundsSimd.AddTo(Bounds);
+#endif
+			for (; Index < End; ++Index)
+			{
+				const FVector3 NewPos = TransformPosition(M, InX[Index], InY[Index], InZ[Index]);
+				OutX[Index] = NewPos.x;
+				OutY[Index] = NewPos.y;
+				OutZ[Index] = NewPos.z;
+				Bounds.Add(NewPos);
+			}
+		});
+}
@@ -0,0 +1,229 @@
+// Indexed mesh and processing stages run after loading
+
+#pragma once
+
+struct FMeshVertex
+{
+	FVector3 Pos;
+	FVector3 Normal;
+	FVector2 UV;
+};
+
+// Contiguous run of indices drawn with one material
+struct FMeshSection
+{
+	uint32 Material;
+	uint32 FirstIndex;
+	uint32 NumIndices;
+
+	// Level of detail this section belongs to (0 is full detail) and that level's simplification error in mesh units
+	uint32 Lod;
+	float LodError;
+};
+
+struct FIndexedMesh
+{
+	std::vector<FMeshVertex> Vertices;
+
+	// Triangle list
+	std::vector<uint32> Indices;
+
+	// In index order, covering all the indices; empty means a single section
+	std::vector<FMeshSection> Sections;
+
+	// Optional, one per vertex from ComputeTangents(): unit tangent and the bitangent sign in w (B = cross(N, T) * w)
+	std::vector<FVector4> Tangents;
+
+	uint32 GetNumTriangles() const
+	{
+		return (uint32)Indices.size() / 3;
+	}
+
+	uint32 GetNumLods() const
+	{
+		return Sections.empty() ? 1 : Sections.back().Lod + 1;
+	}
+
+	// 16 bit indices can address the first 64k vertices
+	bool Needs32BitIndices() const
+	{
+		return Vertices.size() > 65536;
+	}
+};
+
+// Post transform vertex cache efficiency, from a FIFO cache simulation
+struct FVertexCacheStats
+{
+	uint32 NumTransformed = 0;
+
+	// Average cache miss ratio: transformed vertices per triangle (0.5 best case for regular grids, 3 worst)
+	float ACMR = 0;
+
+	// Average transform to vertex ratio: transformed vertices per referenced vertex (1 is optimal)
+	float ATVR = 0;
+};
+
+FVertexCacheStats AnalyzeVertexCache(const FIndexedMesh& Mesh, uint32 CacheSize = 32);
+
+// Reorders triangles so vertices are reused while still in the post transform cache; triangles stay inside their section
+void OptimizeVertexCache(FIndexedMesh& Mesh, uint32 CacheSize = 32);
+
+// Reorders vertices in the order the index buffer uses them, for vertex fetch locality; call after OptimizeVertexCache()
+void OptimizeVertexFetch(FIndexedMesh& Mesh);
+
+// Small cluster of triangles for cluster culling; its vertices and triangles index into FMeshlets' arrays
+struct FMeshlet
+{
+	uint32 Material;
+
+	// NumVertices entries in FMeshlets::Vertices, NumTriangles * 3 local vertex indices in FMeshlets::Triangles
+	uint32 FirstVertex;
+	uint32 FirstTriangle;
+	uint32 NumVertices;
+	uint32 NumTriangles;
+
+	// Bounding sphere
+	FVector3 Center;
+	float Radius;
+
+	// Normal cone: all triangles face away from a camera at Pos if
+	// Dot(Center - Pos, ConeAxis) >= ConeCutoff * Length(Center - Pos) + Radius; ConeCutoff is 1 if the cone is too wide
+	FVector3 ConeAxis;
+	float ConeCutoff;
+};
+
+struct FMeshlets
+{
+	std::vector<FMeshlet> Meshlets;
+
+	// Indices into FIndexedMesh::Vertices
+	std::vector<uint32> Vertices;
+
+	// Three per triangle, relative to the meshlet's FirstVertex
+	std::vector<uint8> Triangles;
+};
+
+// Splits the triangles of LOD 0 in index order (run OptimizeVertexCache() first for tight clusters) without crossing sections.
+// MaxVertices is at most 256; 64/124 fits mesh shader output limits.
+void BuildMeshlets(const FIndexedMesh& Mesh, FMeshlets& OutMeshlets, uint32 MaxVertices = 64, uint32 MaxTriangles = 124);
+
+// Fills OutVisible with the meshlets inside the frustum that have some triangles facing the camera.
+// Frustum and CameraPos are in the mesh's space; triangles are front facing when counter clockwise.
+void CullMeshlets(const FMeshlets& Meshlets, const FFrustum& Frustum, const FVector3& CameraPos, std::vector<uint32>& OutVisible);
+
+// Box and sphere around the positions, computed once at load time for culling the mesh's draws
+struct FMeshBounds
+{
+	FBox Box;
+	FSphere Sphere;
+};
+
+// The sphere is the smaller of the box's circumscribed sphere and Ritter's ("An Efficient Bounding Sphere")
+FMeshBounds ComputeMeshBounds(const FMeshVertex* Vertices, uint32 NumVertices);
+
+// Bounds to test against a frustum many at a time, as structure of arrays so SSE2 does 4 per instruction. Each entry
+// has a box (center/half extent) and a sphere around the same center. The arrays are padded to a multiple of 4 with
+// entries no frustum can see.
+struct FCullBounds
+{
+	std::vector<float> CenterX;
+	std::vector<float> CenterY;
+	std::vector<float> CenterZ;
+	std::vector<float> ExtentX;
+	std::vector<float> ExtentY;
+	std::vector<float> ExtentZ;
+	std::vector<float> Radius;
+	uint32 Num = 0;
+
+	void Clear();
+	void Reserve(uint32 NumBounds);
+
+	// Return the new entry's index; a box gets its circumscribed sphere, a sphere its enclosing box
+	uint32 Add(const FBox& Box);
+	uint32 Add(const FSphere& Sphere);
+	void Set(uint32 Index, const FBox& Box);
+	void Set(uint32 Index, const FSphere& Sphere);
+};
+
+// Fill OutVisible with the indices of the boxes/spheres touching the frustum, in order. The frustum and bounds have
+// to be in the same space, eg world bounds against FFrustum::FromMatrix(View.Mul(Proj)).
+void CullBoxes(const FFrustum& Frustum, const FCullBounds& Bounds, std::vector<uint32>& OutVisible);
+void CullSpheres(const FFrustum& Frustum, const FCullBounds& Bounds, std::vector<uint32>& OutVisible);
+
+// Adds a level of detail per ratio (of LOD 0's triangle count, decreasing) by quadric error edge collapses, each
+// simplified from the previous level. Vertices only collapse onto other vertices, so every level shares the vertex
+// array and appends indices and sections. Vertices on borders, uv/normal seams and material boundaries never move;
+// AttributeWeight makes collapses across differing normals/uvs more expensive.
+// Stops early once a level can't remove at least 10% of the previous one's triangles.
+void BuildLodChain(FIndexedMesh& Mesh, const float* Ratios, uint32 NumRatios, float AttributeWeight = 1.0f);
+
+// Distance based selection: the coarsest level whose error covers at most MaxPixelError pixels at Distance.
+// ProjectionScale is the viewport height / (2 * tan(FOV / 2)).
+uint32 SelectLod(const FMeshSection* Sections, uint32 NumSections, float Distance, float ProjectionScale, float MaxPixelError);
+
+// 12 bytes instead of 24: positions as 16 bit unorm inside the mesh's bounds, octahedral normal as 2 snorm bytes and
+// half float uvs. Pos is fetched as R16G16B16A16_UNORM (the normal ends up in w and is ignored).
+struct FQuantizedVertex
+{
+	uint16 Pos[3];
+	uint16 Normal;	// EncodeOctahedral8()
+	uint16 UV[2];
+};
+static_assert(sizeof(FQuantizedVertex) == 12, "FQuantizedVertex must match the input layout");
+
+// Pos = Quantized / 65535 * Scale + Bias per axis; Scale = 1, Bias = 0 leaves float positions untouched
+struct FVertexQuantization
+{
+	FVector3 Scale;
+	FVector3 Bias;
+
+	static FVertexQuantization GetIdentity()
+	{
+		FVertexQuantization New = {{{{1, 1, 1}}}, {{{0, 0, 0}}}};
+		return New;
+	}
+};
+
+// Bounds of the positions
+FVertexQuantization ComputeVertexQuantization(const FMeshVertex* Vertices, uint32 NumVertices);
+
+// Errors are about half a step per position axis (Scale / 131070), under a degree of normal and half float
+// rounding for uvs (2^-12 in [0.5, 1))
+void QuantizeVertices(const FMeshVertex* Vertices, uint32 NumVertices, const FVertexQuantization& Quantization, FQuantizedVertex* OutVertices);
+FMeshVertex DequantizeVertex(const FQuantizedVertex& Vertex, const FVertexQuantization& Quantization);
+
+// Same layout as FQuantizedVertex but with the whole tangent frame instead of just the normal; 16 bytes
+struct FQuantizedTangentVertex
+{
+	uint16 Pos[3];
+	uint16 Padding;
+	uint32 TangentFrame;	// EncodeTangentFrame()
+	uint16 UV[2];
+};
+static_assert(sizeof(FQuantizedTangentVertex) == 16, "FQuantizedTangentVertex must match the input layout");
+
+// Needs Mesh.Tangents; the tangent frame costs about a degree of normal and tangent precision
+void QuantizeVertices(const FIndexedMesh& Mesh, const FVertexQuantization& Quantization, FQuantizedTangentVertex* OutVertices);
+
+// Batch versions of PackNormalToU32(), EncodeOctahedral16() and EncodeOctahedral8(). Normals are read Stride bytes
+// apart (eg &Vertices[0].Normal, sizeof(FMeshVertex)) and written OutStride bytes apart so vertex buffers can be filled
+// in place. Four at a time with SSE2 when ENABLE_SIMD, giving the same results as the scalar versions.
+void PackNormalsToU32(const FVector3* Normals, uint32 Stride, uint32 NumNormals, uint32* Out, uint32 OutStride);
+void EncodeNormalsOctahedral16(const FVector3* Normals, uint32 Stride, uint32 NumNormals, uint32* Out, uint32 OutStride);
+void EncodeNormalsOctahedral8(const FVector3* Normals, uint32 Stride, uint32 NumNormals, uint16* Out, uint32 OutStride);
+
+// Fills Mesh.Tangents the way MikkTSpace does: per face tangents from the uv gradients, projected onto each vertex's
+// normal plane and weighted by the corner angle, so normal maps baked with it match. Unlike MikkTSpace vertices are not
+// split where mirrored uvs meet, as vertices are already unique per position/uv/normal.
+// Faces run in parallel on NumThreads threads, 0 means one per core.
+void ComputeTangents(FIndexedMesh& Mesh, uint32 NumThreads = 0);
+
+// Pos * M with w = 1, like the shaders' row vectors (M should be affine, there is no divide by w), for CPU skinning or
+// pre-transforming before upload. Positions are read Stride bytes apart and written OutStride bytes apart (eg
+// &Vertices[0].Pos, sizeof(FMeshVertex)); In and Out may be the same array. OutBounds, if not null, gets the box
+// around the transformed positions from the same pass. With SSE when ENABLE_SIMD, one position per register as they
+// are strided; on NumThreads threads (0 means one per core; small arrays use fewer).
+void TransformPositions(const FMatrix4x4& M, const FVector3* In, uint32 Stride, uint32 NumPositions, FVector3* Out, uint32 OutStride, FBox* OutBounds = nullptr, uint32 NumThreads = 1);
+
+// Same for positions split in x/y/z streams, which SSE does four at a time
+void TransformPositions(const FMatrix4x4& M, const float* InX, const float* InY, const float* InZ, uint32 NumPositions, float* OutX, float* OutY, float* OutZ, FBox* OutBounds = nullptr, uint32 NumThreads = 1);
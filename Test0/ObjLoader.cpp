@@ -1,162 +1,1892 @@
 #include "stdafx.h"
 #include "Util.h"
 #include "ObjLoader.h"
+#include <locale.h>
+#include <stddef.h>
+#include <psapi.h>
+#include <intrin.h>
+#include <emmintrin.h>
+#include <string>
 
 namespace Obj
 {
+	static inline bool IsDigit(char c)
+	{
+		return (uint32)(c - '0') < 10;
+	}
+
 	static int32 ReadIntAndAdvance(const char*& Line)
 	{
-		int32 f = atoi(Line);
-		if (Line[0] == '-')
+		bool bNegative = (Line[0] == '-');
+		if (bNegative || Line[0] == '+')
 		{
 			++Line;
 		}
-		while (isdigit(Line[0]))
+
+		int32 Value = 0;
+		while (IsDigit(Line[0]))
 		{
+			Value = Value * 10 + (Line[0] - '0');
 			++Line;
 		}
 
+		return bNegative ? -Value : Value;
+	}
+
+	// Exactly representable powers of ten
+	static const float GFloatPowersOf10[] = {1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f};
+	static const double GDoublePowersOf10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+
+	// Handles long mantissas, huge exponents, inf/nan, etc. through the CRT with a fixed "C" locale
+	static float ReadFloatSlowAndAdvance(const char*& Line)
+	{
+		static _locale_t CLocale = _create_locale(LC_NUMERIC, "C");
+
+		// The whole token is always consumed, so whatever the CRT doesn't parse can't become the next component
+		size_t Length = 0;
+		while (Line[Length] && !strchr(" \t\r\n/", Line[Length]))
+		{
+			++Length;
+		}
+
+		// The line isn't terminated after the token, so it's copied; overly long ones go to the heap
+		char Buffer[128];
+		std::string LongBuffer;
+		char* Token = Buffer;
+		if (Length >= sizeof(Buffer))
+		{
+			LongBuffer.assign(Line, Length);
+			Token = &LongBuffer[0];
+		}
+		else
+		{
+			memcpy(Buffer, Line, Length);
+			Buffer[Length] = 0;
+		}
+
+		float f = _strtof_l(Token, nullptr, CLocale);
+		Line += Length;
 		return f;
 	}
 
+	// Single pass, locale independent and correctly rounded; the common mesh case of a short mantissa is done
+	// with one exact float or double operation (Clinger's fast path), anything else goes through the CRT
 	static float ReadFloatAndAdvance(const char*& Line)
 	{
-		float f = (float)atof(Line);
-		if (Line[0] == '-')
+		while (Line[0] == ' ' || Line[0] == '\t')
+		{
+			++Line;
+		}
+
+		const char* Start = Line;
+		bool bNegative = (Line[0] == '-');
+		if (bNegative || Line[0] == '+')
 		{
 			++Line;
 		}
-		while (isdigit(Line[0]))
+
+		uint64 Mantissa = 0;
+		int32 NumSignificantDigits = 0;
+		int32 NumDigits = 0;
+		int32 Exponent = 0;
+		bool bTruncated = false;
+		while (IsDigit(Line[0]))
 		{
+			if (NumSignificantDigits < 19)
+			{
+				Mantissa = Mantissa * 10 + (Line[0] - '0');
+				NumSignificantDigits += Mantissa ? 1 : 0;
+			}
+			else
+			{
+				bTruncated = true;
+				++Exponent;
+			}
+			++NumDigits;
 			++Line;
 		}
 		if (Line[0] == '.')
 		{
 			++Line;
-			while (isdigit(Line[0]))
+			while (IsDigit(Line[0]))
 			{
+				if (NumSignificantDigits < 19)
+				{
+					Mantissa = Mantissa * 10 + (Line[0] - '0');
+					NumSignificantDigits += Mantissa ? 1 : 0;
+					--Exponent;
+				}
+				else
+				{
+					bTruncated = true;
+				}
+				++NumDigits;
 				++Line;
 			}
 		}
+
+		if (NumDigits == 0)
+		{
+			Line = Start;
+			return ReadFloatSlowAndAdvance(Line);
+		}
+
 		if (Line[0] == 'e' || Line[0] == 'E')
 		{
+			const char* ExponentStart = Line;
 			++Line;
-			if (Line[0] == '-')
+			bool bNegativeExponent = (Line[0] == '-');
+			if (bNegativeExponent || Line[0] == '+')
 			{
 				++Line;
 			}
-			while (isdigit(Line[0]))
+
+			if (IsDigit(Line[0]))
 			{
-				++Line;
+				int32 ExplicitExponent = 0;
+				while (IsDigit(Line[0]))
+				{
+					ExplicitExponent = min(ExplicitExponent * 10 + (Line[0] - '0'), 100000);
+					++Line;
+				}
+				Exponent += bNegativeExponent ? -ExplicitExponent : ExplicitExponent;
+			}
+			else
+			{
+				// Not an exponent, same as strtod
+				Line = ExponentStart;
 			}
 		}
 
-		return f;
+		float Value = 0;
+		if (Mantissa == 0)
+		{
+			Value = 0;
+		}
+		else if (!bTruncated && Mantissa <= (1 << 24) && Exponent >= -10 && Exponent <= 10)
+		{
+			Value = Exponent < 0 ? (float)Mantissa / GFloatPowersOf10[-Exponent] : (float)Mantissa * GFloatPowersOf10[Exponent];
+		}
+		else if (!bTruncated && Mantissa <= (1ull << 53) && Exponent >= -22 && Exponent <= 22)
+		{
+			double d = Exponent < 0 ? (double)Mantissa / GDoublePowersOf10[-Exponent] : (double)Mantissa * GDoublePowersOf10[Exponent];
+
+			// Rounding the double to float is only wrong if the double landed exactly halfway between two floats
+			uint64 Bits;
+			memcpy(&Bits, &d, sizeof(Bits));
+			if ((Bits & 0x1fffffff) == 0x10000000)
+			{
+				Line = Start;
+				return ReadFloatSlowAndAdvance(Line);
+			}
+			Value = (float)d;
+		}
+		else
+		{
+			Line = Start;
+			return ReadFloatSlowAndAdvance(Line);
+		}
+
+		return bNegative ? -Value : Value;
 	}
 
-	bool Load(const char* Filename, FObj& OutObj)
+	float ReadFloat(const char*& Line)
 	{
-		FILE* File = nullptr;
-		fopen_s(&File, Filename, "r");
+		return ReadFloatAndAdvance(Line);
+	}
+
+	static inline void SkipSpaces(const char*& Line)
+	{
+		while (Line[0] == ' ' || Line[0] == '\t')
+		{
+			++Line;
+		}
+	}
 
-		while (!feof(File))
+	static std::string ReadNameAndAdvance(const char*& Line)
+	{
+		SkipSpaces(Line);
+		const char* Start = Line;
+		while (Line[0] && !strchr(" \t\r\n", Line[0]))
 		{
-			char Line[2048];
-			fgets(Line, sizeof(Line) - 2, File);
+			++Line;
+		}
+
+		return std::string(Start, Line);
+	}
 
-			if (Line[0] == '#' || Line[0] == '\n')
+	static uint32 FindOrAddMaterial(FObj& Obj, const std::string& Name)
+	{
+		for (uint32 Index = 0; Index < (uint32)Obj.Materials.size(); ++Index)
+		{
+			if (Obj.Materials[Index].Name == Name)
 			{
-				continue;
+				return Index;
 			}
-			else
+		}
+
+		FMaterial Material;
+		Material.Name = Name;
+		Obj.Materials.push_back(Material);
+		return (uint32)Obj.Materials.size() - 1;
+	}
+
+	// OBJ indices are 1 based, or relative to the end of the list so far if negative; returns a 0 based index
+	// or -1 for a missing one, and sets bit Attribute in OutMask for relative ones
+	static inline int32 ReadIndexAndAdvance(const char*& Line, int32 NumItems, uint16& OutMask, uint32 Attribute)
+	{
+		int32 Index = ReadIntAndAdvance(Line);
+		if (Index < 0)
+		{
+			OutMask |= 1 << Attribute;
+			return Index + NumItems;
+		}
+
+		return Index - 1;
+	}
+
+	static inline FVector3 ParseVector3(const char* Ptr)
+	{
+		FVector3 V;
+		V.x = ReadFloatAndAdvance(Ptr);
+		check(*Ptr++ == ' ');
+		V.y = ReadFloatAndAdvance(Ptr);
+		check(*Ptr++ == ' ');
+		V.z = ReadFloatAndAdvance(Ptr);
+		return V;
+	}
+
+	static inline FVector2 ParseVector2(const char* Ptr)
+	{
+		FVector2 V;
+		V.x = ReadFloatAndAdvance(Ptr);
+		check(*Ptr++ == ' ');
+		V.y = ReadFloatAndAdvance(Ptr);
+		return V;
+	}
+
+	// Calls Emit(const FFace& Face, uint16 RelativeMask) for every triangle of the polygon on the line; polygons are
+	// fanned around their first corner as they are read, so only three corners are kept.
+	// RelativeMask has bit (Corner * 3 + Attribute) set for each negative index, resolved against the NumXXs passed in.
+	template <typename TEmit>
+	static inline void ParseFace(const char* Ptr, int32 NumVs, int32 NumVTs, int32 NumVNs, TEmit Emit)
+	{
+		FFace::FCorner First, Previous;
+		uint16 FirstMask = 0;
+		uint16 PreviousMask = 0;
+		uint32 NumCorners = 0;
+		while (true)
+		{
+			SkipSpaces(Ptr);
+			if (!IsDigit(Ptr[0]) && Ptr[0] != '-' && Ptr[0] != '+')
+			{
+				break;
+			}
+
+			FFace::FCorner Corner;
+			uint16 CornerMask = 0;
+			Corner.Pos = ReadIndexAndAdvance(Ptr, NumVs, CornerMask, 0);
+			Corner.UV = -1;
+			Corner.Normal = -1;
+			if (Ptr[0] == '/')
 			{
-				if (!strncmp(Line, "mtllib", 6))
+				++Ptr;
+				if (Ptr[0] != '/')
 				{
-					continue;
+					Corner.UV = ReadIndexAndAdvance(Ptr, NumVTs, CornerMask, 1);
 				}
-				else if (!strncmp(Line, "usemtl", 6))
+
+				if (Ptr[0] == '/')
 				{
-					continue;
+					++Ptr;
+					Corner.Normal = ReadIndexAndAdvance(Ptr, NumVNs, CornerMask, 2);
 				}
-				else if (!strncmp(Line, "g ", 2))
+			}
+
+			if (NumCorners == 0)
+			{
+				First = Corner;
+				FirstMask = CornerMask;
+			}
+			else if (NumCorners >= 2)
+			{
+				FFace Face;
+				Face.Corners[0] = First;
+				Face.Corners[1] = Previous;
+				Face.Corners[2] = Corner;
+				Emit(Face, (uint16)(FirstMask | (PreviousMask << 3) | (CornerMask << 6)));
+			}
+			Previous = Corner;
+			PreviousMask = CornerMask;
+			++NumCorners;
+		}
+	}
+
+	// push_back() that counts reallocations, to check the counting pass
+	template <typename T>
+	static inline void PushBack(std::vector<T>& Vector, const T& Item, FLoadStats& Stats)
+	{
+		if (Vector.size() == Vector.capacity())
+		{
+			++Stats.NumGrowths;
+			++Stats.NumAllocations;
+		}
+		Vector.push_back(Item);
+	}
+
+	template <typename T>
+	static inline void Reserve(std::vector<T>& Vector, uint64 Size, FLoadStats& Stats)
+	{
+		if (Vector.capacity() < Size)
+		{
+			++Stats.NumAllocations;
+			Vector.reserve((size_t)Size);
+		}
+	}
+
+	static uint64 GetArrayBytes(const FObj& Obj)
+	{
+		return Obj.Vs.capacity() * sizeof(FVector3) + Obj.VTs.capacity() * sizeof(FVector2) + Obj.VNs.capacity() * sizeof(FVector3) + Obj.Faces.capacity() * sizeof(FFace);
+	}
+
+	static void GetProcessPeakMemory(uint64& OutWorkingSetBytes, uint64& OutPrivateBytes)
+	{
+		PROCESS_MEMORY_COUNTERS Counters;
+		MemZero(Counters);
+		if (::GetProcessMemoryInfo(::GetCurrentProcess(), &Counters, sizeof(Counters)))
+		{
+			OutWorkingSetBytes = Counters.PeakWorkingSetSize;
+			OutPrivateBytes = Counters.PeakPagefileUsage;
+		}
+	}
+
+	// Line is terminated by '\n' or '\0'; for the mapped path it points straight into the file view.
+	// If OutRelativeMasks is set, one mask is added per face with bit (Corner * 3 + Attribute) set for each
+	// negative index, which is then resolved against OutObj only; the parallel loader rebases those later.
+	static void ParseLine(const char* Line, FObj& OutObj, FLoadStats& Stats, std::vector<uint16>* OutRelativeMasks = nullptr)
+	{
+		if (Line[0] == '#' || Line[0] == '\n')
+		{
+			return;
+		}
+		else if (!strncmp(Line, "mtllib ", 7))
+		{
+			const char* Ptr = Line + 7;
+			while (true)
+			{
+				std::string Library = ReadNameAndAdvance(Ptr);
+				if (Library.empty())
 				{
-					continue;
+					break;
 				}
-				else if (!strncmp(Line, "v ", 2))
+				else if (std::find(OutObj.MaterialLibraries.begin(), OutObj.MaterialLibraries.end(), Library) == OutObj.MaterialLibraries.end())
 				{
-					const char* Ptr = Line + 2;
-					FVector3 V;
-					V.x = ReadFloatAndAdvance(Ptr);
-					check(*Ptr++ == ' ');
-					V.y = ReadFloatAndAdvance(Ptr);
-					check(*Ptr++ == ' ');
-					V.z = ReadFloatAndAdvance(Ptr);
-					OutObj.Vs.push_back(V);
+					OutObj.MaterialLibraries.push_back(Library);
 				}
-				else if (!strncmp(Line, "vt ", 3))
+			}
+		}
+		else if (!strncmp(Line, "usemtl ", 7))
+		{
+			const char* Ptr = Line + 7;
+			const uint32 Material = FindOrAddMaterial(OutObj, ReadNameAndAdvance(Ptr));
+			const uint32 FirstFace = (uint32)OutObj.Faces.size();
+
+			// NumFaces is filled in once loading is done
+			if (!OutObj.MaterialRanges.empty() && OutObj.MaterialRanges.back().FirstFace == FirstFace)
+			{
+				OutObj.MaterialRanges.back().Material = Material;
+			}
+			else
+			{
+				FMaterialRange Range = {Material, FirstFace, 0};
+				OutObj.MaterialRanges.push_back(Range);
+			}
+		}
+		else if (!strncmp(Line, "g ", 2))
+		{
+			return;
+		}
+		else if (!strncmp(Line, "v ", 2))
+		{
+			PushBack(OutObj.Vs, ParseVector3(Line + 2), Stats);
+		}
+		else if (!strncmp(Line, "vt ", 3))
+		{
+			PushBack(OutObj.VTs, ParseVector2(Line + 3), Stats);
+		}
+		else if (!strncmp(Line, "vn ", 3))
+		{
+			PushBack(OutObj.VNs, ParseVector3(Line + 3), Stats);
+		}
+		else if (!strncmp(Line, "f ", 2))
+		{
+			ParseFace(Line + 2, (int32)OutObj.Vs.size(), (int32)OutObj.VTs.size(), (int32)OutObj.VNs.size(),
+				[&](const FFace& Face, uint16 RelativeMask)
 				{
-					const char* Ptr = Line + 3;
-					FVector2 V;
-					V.x = ReadFloatAndAdvance(Ptr);
-					check(*Ptr == ' ');
-					V.y = ReadFloatAndAdvance(Ptr);
-					OutObj.VTs.push_back(V);
-				}
-				else if (!strncmp(Line, "vn ", 3))
+					PushBack(OutObj.Faces, Face, Stats);
+					if (OutRelativeMasks)
+					{
+						PushBack(*OutRelativeMasks, RelativeMask, Stats);
+					}
+				});
+		}
+	}
+
+	static bool LoadLines(const char* Filename, FObj& OutObj, FLoadStats& Stats)
+	{
+		FILE* File = nullptr;
+		fopen_s(&File, Filename, "r");
+		if (!File)
+		{
+			return false;
+		}
+
+		char Line[2048];
+		while (fgets(Line, sizeof(Line) - 2, File))
+		{
+			ParseLine(Line, OutObj, Stats);
+		}
+
+		fclose(File);
+
+		return true;
+	}
+
+	static void ParseRange(const char* Ptr, const char* End, FObj& OutObj, FLoadStats& Stats, std::vector<uint16>* OutRelativeMasks = nullptr)
+	{
+		while (Ptr < End)
+		{
+			const char* LineEnd = (const char*)memchr(Ptr, '\n', End - Ptr);
+			if (!LineEnd)
+			{
+				// Unterminated last line; copy it so the number parsers can't read past the end of the view
+				char Line[2048];
+				size_t Length = min((size_t)(End - Ptr), sizeof(Line) - 1);
+				memcpy(Line, Ptr, Length);
+				Line[Length] = 0;
+				ParseLine(Line, OutObj, Stats, OutRelativeMasks);
+				break;
+			}
+
+			ParseLine(Ptr, OutObj, Stats, OutRelativeMasks);
+			Ptr = LineEnd + 1;
+		}
+	}
+
+	static inline uint32 CountBits(uint32 Value)
+	{
+		Value = Value - ((Value >> 1) & 0x55555555);
+		Value = (Value & 0x33333333) + ((Value >> 2) & 0x33333333);
+		return (((Value + (Value >> 4)) & 0x0f0f0f0f) * 0x01010101) >> 24;
+	}
+
+	// NumWords is the number of words (runs of non blank characters) on the line
+	static inline void CountLine(const char* Line, const char* LineEnd, uint32 NumWords, FLoadStats& Stats)
+	{
+		const size_t Length = LineEnd - Line;
+		if (Length < 2)
+		{
+			return;
+		}
+		else if (Line[0] == 'v')
+		{
+			if (Line[1] == ' ')
+			{
+				++Stats.NumCountedVs;
+			}
+			else if (Length > 2 && Line[2] == ' ')
+			{
+				Stats.NumCountedVTs += Line[1] == 't' ? 1 : 0;
+				Stats.NumCountedVNs += Line[1] == 'n' ? 1 : 0;
+			}
+		}
+		else if (Line[0] == 'f' && Line[1] == ' ')
+		{
+			// "f" and then one word per corner; one triangle per corner after the second one
+			Stats.NumCountedTriangles += NumWords > 3 ? NumWords - 3 : 0;
+		}
+	}
+
+	// Counting pass so the arrays can be allocated once before parsing. Newlines and the starts of words are found
+	// 16 bytes at a time; a running count of word starts gives the number of corners on face lines.
+	static void CountRecords(const char* Ptr, const char* End, FLoadStats& Stats)
+	{
+		const char* Line = Ptr;
+		uint64 NumWords = 0;
+		uint64 LineFirstWord = 0;
+
+		// Start of the range counts as blank, so a word starting there counts
+		bool bPreviousBlank = true;
+		const __m128i Newline = _mm_set1_epi8('\n');
+		const __m128i Space = _mm_set1_epi8(' ');
+		const __m128i Tab = _mm_set1_epi8('\t');
+		const __m128i Return = _mm_set1_epi8('\r');
+		for (; Ptr + 16 <= End; Ptr += 16)
+		{
+			__m128i Chars = _mm_loadu_si128((const __m128i*)Ptr);
+			__m128i Newlines = _mm_cmpeq_epi8(Chars, Newline);
+			__m128i Blanks = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(Chars, Space), _mm_cmpeq_epi8(Chars, Tab)), _mm_or_si128(_mm_cmpeq_epi8(Chars, Return), Newlines));
+			uint32 NewlineMask = (uint32)_mm_movemask_epi8(Newlines);
+			uint32 BlankMask = (uint32)_mm_movemask_epi8(Blanks);
+			uint32 WordStartMask = ~BlankMask & ((BlankMask << 1) | (bPreviousBlank ? 1 : 0)) & 0xffff;
+			bPreviousBlank = (BlankMask & 0x8000) != 0;
+
+			while (NewlineMask)
+			{
+				unsigned long Bit;
+				_BitScanForward(&Bit, NewlineMask);
+				uint64 WordsAtNewline = NumWords + CountBits(WordStartMask & ((1u << Bit) - 1));
+				CountLine(Line, Ptr + Bit, (uint32)(WordsAtNewline - LineFirstWord), Stats);
+				LineFirstWord = WordsAtNewline;
+				Line = Ptr + Bit + 1;
+				NewlineMask &= NewlineMask - 1;
+			}
+			NumWords += CountBits(WordStartMask);
+		}
+
+		for (; Ptr < End; ++Ptr)
+		{
+			bool bBlank = *Ptr == ' ' || *Ptr == '\t' || *Ptr == '\r' || *Ptr == '\n';
+			NumWords += !bBlank && bPreviousBlank ? 1 : 0;
+			bPreviousBlank = bBlank;
+			if (*Ptr == '\n')
+			{
+				CountLine(Line, Ptr, (uint32)(NumWords - LineFirstWord), Stats);
+				LineFirstWord = NumWords;
+				Line = Ptr + 1;
+			}
+		}
+
+		if (Line < End)
+		{
+			CountLine(Line, End, (uint32)(NumWords - LineFirstWord), Stats);
+		}
+	}
+
+	static void ReserveCounted(FObj& Obj, const FLoadStats& Counts, FLoadStats& Stats)
+	{
+		Reserve(Obj.Vs, Obj.Vs.size() + Counts.NumCountedVs, Stats);
+		Reserve(Obj.VTs, Obj.VTs.size() + Counts.NumCountedVTs, Stats);
+		Reserve(Obj.VNs, Obj.VNs.size() + Counts.NumCountedVNs, Stats);
+		Reserve(Obj.Faces, Obj.Faces.size() + Counts.NumCountedTriangles, Stats);
+	}
+
+	static bool LoadMapped(const char* Filename, FObj& OutObj, FLoadStats& Stats)
+	{
+		FMappedFile File;
+		if (!File.Open(Filename))
+		{
+			return false;
+		}
+
+		CountRecords(File.GetData(), File.GetData() + File.GetSize(), Stats);
+		ReserveCounted(OutObj, Stats, Stats);
+		ParseRange(File.GetData(), File.GetData() + File.GetSize(), OutObj, Stats);
+		Stats.PeakBytes = max(Stats.PeakBytes, GetArrayBytes(OutObj));
+
+		File.Close();
+
+		return true;
+	}
+
+	static bool LoadParallel(const char* Filename, FObj& OutObj, uint32 NumThreads, FLoadStats& Stats)
+	{
+		FMappedFile File;
+		if (!File.Open(Filename))
+		{
+			return false;
+		}
+
+		const char* Data = File.GetData();
+		const char* End = Data + File.GetSize();
+
+		NumThreads = NumThreads ? NumThreads : GetNumberOfCores();
+		NumThreads = (uint32)max(min((uint64)NumThreads, File.GetSize() / (64 * 1024)), 1ull);
+
+		// Split on line boundaries
+		std::vector<const char*> Splits(NumThreads + 1);
+		Splits[0] = Data;
+		Splits[NumThreads] = End;
+		for (uint32 Index = 1; Index < NumThreads; ++Index)
+		{
+			const char* Split = max(Data + File.GetSize() * Index / NumThreads, Splits[Index - 1]);
+			const char* LineEnd = (const char*)memchr(Split, '\n', End - Split);
+			Splits[Index] = LineEnd ? LineEnd + 1 : End;
+		}
+
+		struct FChunk
+		{
+			FObj Obj;
+			std::vector<uint16> RelativeMasks;
+			FLoadStats Stats;
+			uint32 FirstV = 0;
+			uint32 FirstVT = 0;
+			uint32 FirstVN = 0;
+			uint32 FirstFace = 0;
+		};
+		std::vector<FChunk> Chunks(NumThreads);
+
+		RunOnThreads(NumThreads,
+			[&](uint32 ThreadIndex)
+			{
+				auto& Chunk = Chunks[ThreadIndex];
+				CountRecords(Splits[ThreadIndex], Splits[ThreadIndex + 1], Chunk.Stats);
+				ReserveCounted(Chunk.Obj, Chunk.Stats, Chunk.Stats);
+				Reserve(Chunk.RelativeMasks, Chunk.Stats.NumCountedTriangles, Chunk.Stats);
+				ParseRange(Splits[ThreadIndex], Splits[ThreadIndex + 1], Chunk.Obj, Chunk.Stats, &Chunk.RelativeMasks);
+			});
+
+		// Appending to whatever OutObj already holds, same as the serial loader
+		uint32 NumVs = (uint32)OutObj.Vs.size();
+		uint32 NumVTs = (uint32)OutObj.VTs.size();
+		uint32 NumVNs = (uint32)OutObj.VNs.size();
+		uint32 NumFaces = (uint32)OutObj.Faces.size();
+		uint64 ChunkBytes = 0;
+		for (auto& Chunk : Chunks)
+		{
+			Stats.NumCountedVs += Chunk.Stats.NumCountedVs;
+			Stats.NumCountedVTs += Chunk.Stats.NumCountedVTs;
+			Stats.NumCountedVNs += Chunk.Stats.NumCountedVNs;
+			Stats.NumCountedTriangles += Chunk.Stats.NumCountedTriangles;
+			Stats.NumAllocations += Chunk.Stats.NumAllocations;
+			Stats.NumGrowths += Chunk.Stats.NumGrowths;
+			ChunkBytes += GetArrayBytes(Chunk.Obj) + Chunk.RelativeMasks.capacity() * sizeof(uint16);
+
+			Chunk.FirstV = NumVs;
+			Chunk.FirstVT = NumVTs;
+			Chunk.FirstVN = NumVNs;
+			Chunk.FirstFace = NumFaces;
+			NumVs += (uint32)Chunk.Obj.Vs.size();
+			NumVTs += (uint32)Chunk.Obj.VTs.size();
+			NumVNs += (uint32)Chunk.Obj.VNs.size();
+			NumFaces += (uint32)Chunk.Obj.Faces.size();
+
+			// Materials are few, so merge them by name here; faces before a chunk's first usemtl keep the previous
+			// chunk's material when the ranges are finished
+			for (auto& Library : Chunk.Obj.MaterialLibraries)
+			{
+				if (std::find(OutObj.MaterialLibraries.begin(), OutObj.MaterialLibraries.end(), Library) == OutObj.MaterialLibraries.end())
 				{
-					const char* Ptr = Line + 3;
-					FVector3 V;
-					V.x = ReadFloatAndAdvance(Ptr);
-					check(*Ptr++ == ' ');
-					V.y = ReadFloatAndAdvance(Ptr);
-					check(*Ptr++ == ' ');
-					V.z = ReadFloatAndAdvance(Ptr);
-					OutObj.VNs.push_back(V);
+					OutObj.MaterialLibraries.push_back(Library);
 				}
-				else if (!strncmp(Line, "f ", 2))
+			}
+
+			for (auto Range : Chunk.Obj.MaterialRanges)
+			{
+				Range.Material = FindOrAddMaterial(OutObj, Chunk.Obj.Materials[Range.Material].Name);
+				Range.FirstFace += Chunk.FirstFace;
+				OutObj.MaterialRanges.push_back(Range);
+			}
+		}
+
+		Reserve(OutObj.Vs, NumVs, Stats);
+		Reserve(OutObj.VTs, NumVTs, Stats);
+		Reserve(OutObj.VNs, NumVNs, Stats);
+		Reserve(OutObj.Faces, NumFaces, Stats);
+		OutObj.Vs.resize(NumVs);
+		OutObj.VTs.resize(NumVTs);
+		OutObj.VNs.resize(NumVNs);
+		OutObj.Faces.resize(NumFaces);
+		Stats.PeakBytes = max(Stats.PeakBytes, ChunkBytes + GetArrayBytes(OutObj));
+
+		// Stitch; relative indices were only resolved against their own chunk so add everything before it
+		RunOnThreads(NumThreads,
+			[&](uint32 ThreadIndex)
+			{
+				auto& Chunk = Chunks[ThreadIndex];
+				std::copy(Chunk.Obj.Vs.begin(), Chunk.Obj.Vs.end(), OutObj.Vs.begin() + Chunk.FirstV);
+				std::copy(Chunk.Obj.VTs.begin(), Chunk.Obj.VTs.end(), OutObj.VTs.begin() + Chunk.FirstVT);
+				std::copy(Chunk.Obj.VNs.begin(), Chunk.Obj.VNs.end(), OutObj.VNs.begin() + Chunk.FirstVN);
+
+				const int32 Bases[3] = {(int32)Chunk.FirstV, (int32)Chunk.FirstVT, (int32)Chunk.FirstVN};
+				for (uint32 Index = 0; Index < (uint32)Chunk.Obj.Faces.size(); ++Index)
 				{
-					const char* Ptr = Line + 2;
-					FFace Face;
-					for (uint32 Index = 0; Index < 3; ++Index)
+					FFace Face = Chunk.Obj.Faces[Index];
+					uint16 Mask = Chunk.RelativeMasks[Index];
+					for (uint32 Corner = 0; Mask && Corner < 3; ++Corner)
 					{
+						int32* Indices = &Face.Corners[Corner].Pos;
+						for (uint32 Attribute = 0; Attribute < 3; ++Attribute)
 						{
-							int32 VIndex = ReadIntAndAdvance(Ptr);
-							if (VIndex < 0)
-							{
-								VIndex = VIndex + (int32)OutObj.Vs.size();
-							}
-							Face.Corners[Index].Pos = VIndex;
-						}
-						check(*Ptr++ == '/');
-						{
-							int32 VIndex = ReadIntAndAdvance(Ptr);
-							if (VIndex < 0)
-							{
-								VIndex = VIndex + (int32)OutObj.VTs.size();
-							}
-							Face.Corners[Index].UV = VIndex;
-						}
-						check(*Ptr++ == '/');
-						{
-							int32 VIndex = ReadIntAndAdvance(Ptr);
-							if (VIndex < 0)
+							if (Mask & (1 << (Corner * 3 + Attribute)))
 							{
-								VIndex = VIndex + (int32)OutObj.VNs.size();
+								Indices[Attribute] += Bases[Attribute];
 							}
-							Face.Corners[Index].Normal = VIndex;
-						}
-						if (Index < 2)
-						{
-							check(*Ptr++ == ' ');
 						}
 					}
-					OutObj.Faces.push_back(Face);
+					OutObj.Faces[Chunk.FirstFace + Index] = Face;
 				}
-			}
+			});
+
+		File.Close();
+
+		return true;
+	}
+
+	// The keys ParseMaterialLibrary() reads; only these start another statement on the same line
+	static const char* GMaterialKeys[] = {"Ka", "Kd", "Ks", "Ke", "Ns", "d", "Tr", "illum", "map_Kd"};
+
+	static bool IsMaterialKey(const char* Ptr)
+	{
+		for (const char* Key : GMaterialKeys)
+		{
+			const size_t Length = strlen(Key);
+			if (!strncmp(Ptr, Key, Length) && (Ptr[Length] == ' ' || Ptr[Length] == '\t'))
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static void ParseMaterialLibrary(const char* Filename, FObj& Obj)
+	{
+		FMappedFile File;
+		if (!File.Open(Filename))
+		{
+			return;
+		}
+
+		// Copy so every line is terminated for the number parsers
+		std::string Data;
+		if (File.GetSize())
+		{
+			Data.assign(File.GetData(), (size_t)File.GetSize());
+		}
+		File.Close();
+
+		auto SkipLine = [&](const char*& Line)
+		{
+			const char* LineEnd = strchr(Line, '\n');
+			Line = LineEnd ? LineEnd + 1 : Data.c_str() + Data.size();
+		};
+
+		// Only materials the .obj uses are kept
+		FMaterial* Material = nullptr;
+		const char* Ptr = Data.c_str();
+		while (*Ptr)
+		{
+			SkipSpaces(Ptr);
+			if (*Ptr == '#' || *Ptr == '\r' || *Ptr == '\n')
+			{
+				SkipLine(Ptr);
+				continue;
+			}
+
+			std::string Key = ReadNameAndAdvance(Ptr);
+			if (Key == "newmtl")
+			{
+				std::string Name = ReadNameAndAdvance(Ptr);
+				Material = nullptr;
+				for (auto& Used : Obj.Materials)
+				{
+					if (Used.Name == Name)
+					{
+						Material = &Used;
+						break;
+					}
+				}
+			}
+			else if (Material)
+			{
+				auto ReadColor = [&](FVector3& Out)
+				{
+					Out.x = ReadFloatAndAdvance(Ptr);
+					SkipSpaces(Ptr);
+
+					// A single value means grey
+					if (IsDigit(Ptr[0]) || Ptr[0] == '.' || Ptr[0] == '-')
+					{
+						Out.y = ReadFloatAndAdvance(Ptr);
+						Out.z = ReadFloatAndAdvance(Ptr);
+					}
+					else
+					{
+						Out.y = Out.z = Out.x;
+					}
+				};
+
+				if (Key == "Ka")
+				{
+					ReadColor(Material->Ambient);
+				}
+				else if (Key == "Kd")
+				{
+					ReadColor(Material->Diffuse);
+				}
+				else if (Key == "Ks")
+				{
+					ReadColor(Material->Specular);
+				}
+				else if (Key == "Ke")
+				{
+					ReadColor(Material->Emissive);
+				}
+				else if (Key == "Ns")
+				{
+					Material->SpecularExponent = ReadFloatAndAdvance(Ptr);
+				}
+				else if (Key == "d")
+				{
+					Material->Opacity = ReadFloatAndAdvance(Ptr);
+				}
+				else if (Key == "Tr")
+				{
+					Material->Opacity = 1.0f - ReadFloatAndAdvance(Ptr);
+				}
+				else if (Key == "illum")
+				{
+					SkipSpaces(Ptr);
+					Material->IlluminationModel = (uint32)ReadIntAndAdvance(Ptr);
+				}
+				else if (Key == "map_Kd")
+				{
+					Material->DiffuseTexture = ReadNameAndAdvance(Ptr);
+				}
+			}
+
+			// Some exporters put several statements on one line ("Tr 0  illum 2"); anything else left is skipped, eg
+			// options or the rest of a texture name with spaces
+			SkipSpaces(Ptr);
+			if (!IsMaterialKey(Ptr))
+			{
+				SkipLine(Ptr);
+			}
+		}
+	}
+
+	// Loads the material libraries, completes the ranges and makes every material a single contiguous range
+	static void FinishMaterials(const char* Filename, FObj& Obj, FLoadStats& Stats)
+	{
+		std::string Directory(Filename);
+		size_t Slash = Directory.find_last_of("/\\");
+		Directory = Slash == std::string::npos ? std::string() : Directory.substr(0, Slash + 1);
+		for (auto& Library : Obj.MaterialLibraries)
+		{
+			ParseMaterialLibrary((Directory + Library).c_str(), Obj);
+		}
+
+		const uint32 NumFaces = (uint32)Obj.Faces.size();
+		if (NumFaces == 0)
+		{
+			Obj.MaterialRanges.clear();
+			return;
+		}
+
+		// Faces before any usemtl get an unnamed default material
+		if (Obj.MaterialRanges.empty() || Obj.MaterialRanges[0].FirstFace > 0)
+		{
+			FMaterialRange Range = {FindOrAddMaterial(Obj, std::string()), 0, 0};
+			Obj.MaterialRanges.insert(Obj.MaterialRanges.begin(), Range);
+		}
+
+		std::vector<uint32> FacesPerMaterial(Obj.Materials.size(), 0);
+		uint32 NumRanges = 0;
+		for (uint32 Index = 0; Index < (uint32)Obj.MaterialRanges.size(); ++Index)
+		{
+			FMaterialRange& Range = Obj.MaterialRanges[Index];
+			uint32 End = Index + 1 < (uint32)Obj.MaterialRanges.size() ? Obj.MaterialRanges[Index + 1].FirstFace : NumFaces;
+			Range.NumFaces = End - Range.FirstFace;
+			NumRanges += Range.NumFaces ? 1 : 0;
+			FacesPerMaterial[Range.Material] += Range.NumFaces;
+		}
+
+		// Materials keep the order they first appear in
+		std::vector<FMaterialRange> Sorted;
+		std::vector<bool> bPlaced(Obj.Materials.size(), false);
+		uint32 FirstFace = 0;
+		for (auto& Range : Obj.MaterialRanges)
+		{
+			if (Range.NumFaces && !bPlaced[Range.Material])
+			{
+				FMaterialRange New = {Range.Material, FirstFace, FacesPerMaterial[Range.Material]};
+				Sorted.push_back(New);
+				bPlaced[Range.Material] = true;
+				FirstFace += New.NumFaces;
+			}
+		}
+
+		// Stable counting sort; nothing to do if every material is already contiguous
+		if (NumRanges != (uint32)Sorted.size())
+		{
+			std::vector<uint32> Slot(Obj.Materials.size(), 0);
+			for (auto& Range : Sorted)
+			{
+				Slot[Range.Material] = Range.FirstFace;
+			}
+
+			// Both face arrays are alive until the swap
+			std::vector<FFace> Faces(NumFaces);
+			++Stats.NumAllocations;
+			Stats.PeakBytes = max(Stats.PeakBytes, GetArrayBytes(Obj) + Faces.capacity() * sizeof(FFace));
+			for (auto& Range : Obj.MaterialRanges)
+			{
+				std::copy(Obj.Faces.begin() + Range.FirstFace, Obj.Faces.begin() + Range.FirstFace + Range.NumFaces, Faces.begin() + Slot[Range.Material]);
+				Slot[Range.Material] += Range.NumFaces;
+			}
+			Obj.Faces.swap(Faces);
+		}
+
+		Obj.MaterialRanges.swap(Sorted);
+	}
+
+	bool Load(const char* Filename, FObj& OutObj, ELoadMode Mode, uint32 NumThreads, FLoadStats* OutStats)
+	{
+		FLoadStats Stats;
+		bool bLoaded = false;
+		switch (Mode)
+		{
+		case ELoadMode::Lines:
+			bLoaded = LoadLines(Filename, OutObj, Stats);
+			break;
+
+		case ELoadMode::Mapped:
+			bLoaded = LoadMapped(Filename, OutObj, Stats);
+			break;
+
+		case ELoadMode::Parallel:
+			bLoaded = LoadParallel(Filename, OutObj, NumThreads, Stats);
+			break;
+
+		default:
+			check(0);
+			break;
+		}
+
+		if (bLoaded)
+		{
+			FinishMaterials(Filename, OutObj, Stats);
+		}
+
+		if (OutStats)
+		{
+			Stats.FinalBytes = GetArrayBytes(OutObj);
+			Stats.PeakBytes = max(Stats.PeakBytes, Stats.FinalBytes);
+			GetProcessPeakMemory(Stats.PeakWorkingSetBytes, Stats.PeakPrivateBytes);
+			*OutStats = Stats;
+		}
+
+		return bLoaded;
+	}
+
+	enum
+	{
+		STREAM_READ_SIZE = 4 * 1024 * 1024,
+		STREAM_REREAD_SIZE = 64 * 1024,
+
+		// Items per attribute block, and blocks kept per attribute
+		STREAM_BLOCK_SIZE = 1024,
+		STREAM_CACHED_BLOCKS = 256,
+	};
+
+	// One of v/vt/vn for the streaming loader: an LRU cache of blocks of items, plus the file offset of the first
+	// item of every block so evicted blocks can be parsed again
+	template <typename T>
+	struct FStreamAttribute
+	{
+		const char* Prefix;
+		T (*Parse)(const char*);
+		FILE* File = nullptr;
+		std::vector<char>* ReadBuffer = nullptr;
+		uint64* NumReloads = nullptr;
+
+		int32 Count = 0;
+		std::vector<uint64> BlockOffsets;
+		std::vector<int32> BlockSlots;
+
+		std::vector<T> Slots;
+		std::vector<int32> SlotBlocks;
+		std::vector<uint64> SlotLastUse;
+		uint64 Clock = 0;
+
+		void Init(const char* InPrefix, T (*InParse)(const char*), FILE* InFile, std::vector<char>* InReadBuffer, uint64* InNumReloads)
+		{
+			Prefix = InPrefix;
+			Parse = InParse;
+			File = InFile;
+			ReadBuffer = InReadBuffer;
+			NumReloads = InNumReloads;
+			Slots.resize(STREAM_BLOCK_SIZE * STREAM_CACHED_BLOCKS);
+			SlotBlocks.resize(STREAM_CACHED_BLOCKS, -1);
+			SlotLastUse.resize(STREAM_CACHED_BLOCKS, 0);
+		}
+
+		void Add(const T& Item, uint64 LineOffset)
+		{
+			if (Count % STREAM_BLOCK_SIZE == 0)
+			{
+				BlockOffsets.push_back(LineOffset);
+				BlockSlots.push_back(-1);
+			}
+
+			int32 Slot = GetSlot(Count / STREAM_BLOCK_SIZE);
+			Slots[Slot * STREAM_BLOCK_SIZE + Count % STREAM_BLOCK_SIZE] = Item;
+			++Count;
+		}
+
+		T Get(int32 Index)
+		{
+			if ((uint32)Index >= (uint32)Count)
+			{
+				return T::GetZero();
+			}
+
+			int32 Slot = GetSlot(Index / STREAM_BLOCK_SIZE);
+			return Slots[Slot * STREAM_BLOCK_SIZE + Index % STREAM_BLOCK_SIZE];
+		}
+
+		int32 GetSlot(int32 Block)
+		{
+			int32 Slot = BlockSlots[Block];
+			if (Slot == -1)
+			{
+				// Evict the least recently used block
+				Slot = 0;
+				for (int32 Index = 1; Index < STREAM_CACHED_BLOCKS; ++Index)
+				{
+					if (SlotLastUse[Index] < SlotLastUse[Slot])
+					{
+						Slot = Index;
+					}
+				}
+
+				if (SlotBlocks[Slot] != -1)
+				{
+					BlockSlots[SlotBlocks[Slot]] = -1;
+				}
+				SlotBlocks[Slot] = Block;
+				BlockSlots[Block] = Slot;
+
+				const int32 NumItems = min(Count - Block * STREAM_BLOCK_SIZE, (int32)STREAM_BLOCK_SIZE);
+				if (NumItems > 0)
+				{
+					Reload(Block, &Slots[Slot * STREAM_BLOCK_SIZE], NumItems);
+				}
+			}
+
+			SlotLastUse[Slot] = ++Clock;
+			return Slot;
+		}
+
+		void Reload(int32 Block, T* Out, int32 NumItems)
+		{
+			++*NumReloads;
+			const size_t PrefixLength = strlen(Prefix);
+			std::vector<char>& Buffer = *ReadBuffer;
+			uint64 Offset = BlockOffsets[Block];
+			int32 NumRead = 0;
+			while (NumRead < NumItems)
+			{
+				_fseeki64(File, Offset, SEEK_SET);
+				size_t Size = fread(Buffer.data(), 1, Buffer.size() - 1, File);
+				Buffer[Size] = 0;
+				const bool bEnd = Size < Buffer.size() - 1;
+				const char* Ptr = Buffer.data();
+				const char* End = Ptr + Size;
+				while (Ptr < End && NumRead < NumItems)
+				{
+					const char* LineEnd = (const char*)memchr(Ptr, '\n', End - Ptr);
+					if (!LineEnd && !bEnd)
+					{
+						// Read again from the start of this line
+						break;
+					}
+
+					if (!strncmp(Ptr, Prefix, PrefixLength))
+					{
+						Out[NumRead++] = Parse(Ptr + PrefixLength);
+					}
+					Ptr = LineEnd ? LineEnd + 1 : End;
+				}
+
+				if (bEnd || Ptr == Buffer.data())
+				{
+					break;
+				}
+				Offset += Ptr - Buffer.data();
+			}
+
+			// Only if the file changed underneath us
+			for (; NumRead < NumItems; ++NumRead)
+			{
+				Out[NumRead] = T::GetZero();
+			}
+		}
+
+		uint64 GetAllocatedSize() const
+		{
+			return Slots.capacity() * sizeof(T) + SlotBlocks.capacity() * sizeof(int32) + SlotLastUse.capacity() * sizeof(uint64) +
+				BlockOffsets.capacity() * sizeof(uint64) + BlockSlots.capacity() * sizeof(int32);
+		}
+	};
+
+	bool LoadStreaming(const char* Filename, uint32 TrianglesPerBatch, FStreamBatchFunction Function, void* UserData, FStreamStats* OutStats)
+	{
+		check(TrianglesPerBatch > 0);
+
+		// One handle reads the file front to back, the other one reloads evicted attribute blocks
+		FILE* File = nullptr;
+		FILE* ReloadFile = nullptr;
+		fopen_s(&File, Filename, "rb");
+		fopen_s(&ReloadFile, Filename, "rb");
+		if (!File || !ReloadFile)
+		{
+			if (File)
+			{
+				fclose(File);
+			}
+			if (ReloadFile)
+			{
+				fclose(ReloadFile);
+			}
+			return false;
 		}
 
+		FStreamStats Stats;
+		std::vector<char> ReloadBuffer(STREAM_REREAD_SIZE + 1);
+		FStreamAttribute<FVector3> Vs;
+		FStreamAttribute<FVector2> VTs;
+		FStreamAttribute<FVector3> VNs;
+		Vs.Init("v ", ParseVector3, ReloadFile, &ReloadBuffer, &Stats.NumBlockReloads);
+		VTs.Init("vt ", ParseVector2, ReloadFile, &ReloadBuffer, &Stats.NumBlockReloads);
+		VNs.Init("vn ", ParseVector3, ReloadFile, &ReloadBuffer, &Stats.NumBlockReloads);
+
+		std::vector<FMeshVertex> Batch;
+		Batch.reserve(TrianglesPerBatch * 3);
+		std::string Material;
+
+		auto Flush = [&]()
+		{
+			if (!Batch.empty())
+			{
+				FStreamBatch Out;
+				Out.Vertices = Batch.data();
+				Out.NumTriangles = (uint32)Batch.size() / 3;
+				Out.Material = Material.c_str();
+				Function(Out, UserData);
+				Stats.NumTriangles += Out.NumTriangles;
+				++Stats.NumBatches;
+				Batch.clear();
+			}
+		};
+
+		auto EmitFace = [&](const FFace& Face, uint16 RelativeMask)
+		{
+			for (uint32 Index = 0; Index < 3; ++Index)
+			{
+				const FFace::FCorner& Corner = Face.Corners[Index];
+				FMeshVertex Vertex;
+				Vertex.Pos = Vs.Get(Corner.Pos);
+				Vertex.Normal = VNs.Get(Corner.Normal);
+				Vertex.UV = VTs.Get(Corner.UV);
+				Batch.push_back(Vertex);
+			}
+
+			if (Batch.size() == TrianglesPerBatch * 3)
+			{
+				Flush();
+			}
+		};
+
+		auto ParseStreamLine = [&](const char* Line, uint64 LineOffset)
+		{
+			if (!strncmp(Line, "v ", 2))
+			{
+				Vs.Add(ParseVector3(Line + 2), LineOffset);
+			}
+			else if (!strncmp(Line, "vt ", 3))
+			{
+				VTs.Add(ParseVector2(Line + 3), LineOffset);
+			}
+			else if (!strncmp(Line, "vn ", 3))
+			{
+				VNs.Add(ParseVector3(Line + 3), LineOffset);
+			}
+			else if (!strncmp(Line, "f ", 2))
+			{
+				ParseFace(Line + 2, Vs.Count, VTs.Count, VNs.Count, EmitFace);
+			}
+			else if (!strncmp(Line, "usemtl ", 7))
+			{
+				const char* Ptr = Line + 7;
+				std::string Name = ReadNameAndAdvance(Ptr);
+				if (Name != Material)
+				{
+					Flush();
+					Material = Name;
+				}
+			}
+		};
+
+		// Lines are parsed in place; a partial line at the end of the buffer is moved to the front before reading more
+		std::vector<char> Buffer(STREAM_READ_SIZE + 1);
+		uint64 BufferOffset = 0;
+		size_t NumLeftover = 0;
+		bool bEnd = false;
+		while (!bEnd)
+		{
+			size_t Size = NumLeftover + fread(Buffer.data() + NumLeftover, 1, STREAM_READ_SIZE - NumLeftover, File);
+			bEnd = Size < STREAM_READ_SIZE;
+			Buffer[Size] = 0;
+
+			const char* Ptr = Buffer.data();
+			const char* End = Ptr + Size;
+			while (Ptr < End)
+			{
+				const char* LineEnd = (const char*)memchr(Ptr, '\n', End - Ptr);
+				if (!LineEnd && !bEnd && Ptr != Buffer.data())
+				{
+					break;
+				}
+
+				// Either a complete line, the unterminated last one, or one longer than the buffer which gets truncated
+				ParseStreamLine(Ptr, BufferOffset + (Ptr - Buffer.data()));
+				Ptr = LineEnd ? LineEnd + 1 : End;
+			}
+
+			NumLeftover = End - Ptr;
+			memmove(Buffer.data(), Ptr, NumLeftover);
+			BufferOffset += Ptr - Buffer.data();
+		}
+
+		Flush();
+
 		fclose(File);
+		fclose(ReloadFile);
+
+		if (OutStats)
+		{
+			// Everything only grows, so the final size is the peak
+			Stats.PeakLoaderBytes = Buffer.capacity() + ReloadBuffer.capacity() + Batch.capacity() * sizeof(FMeshVertex) +
+				Vs.GetAllocatedSize() + VTs.GetAllocatedSize() + VNs.GetAllocatedSize();
+
+			GetProcessPeakMemory(Stats.PeakWorkingSetBytes, Stats.PeakPrivateBytes);
+			*OutStats = Stats;
+		}
 
 		return true;
 	}
+
+	void GenerateNormals(FObj& Obj, float CreaseAngleDegrees, uint32 NumThreads)
+	{
+		NumThreads = NumThreads ? NumThreads : GetNumberOfCores();
+		const uint32 NumFaces = (uint32)Obj.Faces.size();
+		const uint32 NumVs = (uint32)Obj.Vs.size();
+		auto IsValid = [&](const FFace::FCorner& Corner)
+		{
+			return (uint32)Corner.Pos < NumVs;
+		};
+
+		// Unit face normals and the angle at each corner
+		std::vector<FVector3> FaceNormals(NumFaces);
+		std::vector<float> CornerAngles((size_t)NumFaces * 3);
+		RunOnThreads(NumThreads,
+			[&](uint32 ThreadIndex)
+			{
+				const uint32 Begin = (uint32)((uint64)NumFaces * ThreadIndex / NumThreads);
+				const uint32 End = (uint32)((uint64)NumFaces * (ThreadIndex + 1) / NumThreads);
+				for (uint32 FaceIndex = Begin; FaceIndex < End; ++FaceIndex)
+				{
+					const FFace& Face = Obj.Faces[FaceIndex];
+					if (!IsValid(Face.Corners[0]) || !IsValid(Face.Corners[1]) || !IsValid(Face.Corners[2]))
+					{
+						FaceNormals[FaceIndex] = FVector3::GetZero();
+						CornerAngles[FaceIndex * 3 + 0] = CornerAngles[FaceIndex * 3 + 1] = CornerAngles[FaceIndex * 3 + 2] = 0;
+						continue;
+					}
+
+					const FVector3& P0 = Obj.Vs[Face.Corners[0].Pos];
+					const FVector3& P1 = Obj.Vs[Face.Corners[1].Pos];
+					const FVector3& P2 = Obj.Vs[Face.Corners[2].Pos];
+					const FVector3 Edge01 = P1.Sub(P0);
+					const FVector3 Edge12 = P2.Sub(P1);
+					const FVector3 Edge20 = P0.Sub(P2);
+					FaceNormals[FaceIndex] = Edge01.Cross(Edge20).Mul(-1.0f).GetNormalized();
+
+					// The third angle is what's left of pi
+					const float Length01 = Edge01.Length();
+					const float Length12 = Edge12.Length();
+					const float Length20 = Edge20.Length();
+					const float Cos0 = Length01 * Length20 > 0 ? -Edge01.Dot(Edge20) / (Length01 * Length20) : 1.0f;
+					const float Cos1 = Length01 * Length12 > 0 ? -Edge01.Dot(Edge12) / (Length01 * Length12) : 1.0f;
+					const float Angle0 = acosf(min(max(Cos0, -1.0f), 1.0f));
+					const float Angle1 = acosf(min(max(Cos1, -1.0f), 1.0f));
+					CornerAngles[FaceIndex * 3 + 0] = Angle0;
+					CornerAngles[FaceIndex * 3 + 1] = Angle1;
+					CornerAngles[FaceIndex * 3 + 2] = max(3.14159265f - Angle0 - Angle1, 0.0f);
+				}
+			});
+
+		// Position -> corners (FaceIndex * 3 + Corner), so each thread can gather the faces of its own range of positions.
+		// Offsets are turned into range ends and walked back while filling, which leaves the range starts.
+		std::vector<uint32> CornerOffsets(NumVs + 1, 0);
+		for (const FFace& Face : Obj.Faces)
+		{
+			for (uint32 Corner = 0; Corner < 3; ++Corner)
+			{
+				if (IsValid(Face.Corners[Corner]))
+				{
+					++CornerOffsets[Face.Corners[Corner].Pos];
+				}
+			}
+		}
+		for (uint32 Index = 0; Index < NumVs; ++Index)
+		{
+			CornerOffsets[Index + 1] += CornerOffsets[Index];
+		}
+		std::vector<uint32> PosCorners(CornerOffsets[NumVs]);
+		for (uint32 FaceIndex = NumFaces; FaceIndex-- > 0;)
+		{
+			for (uint32 Corner = 3; Corner-- > 0;)
+			{
+				const FFace::FCorner& FaceCorner = Obj.Faces[FaceIndex].Corners[Corner];
+				if (IsValid(FaceCorner))
+				{
+					PosCorners[--CornerOffsets[FaceCorner.Pos]] = FaceIndex * 3 + Corner;
+				}
+			}
+		}
+		CornerOffsets[NumVs] = (uint32)PosCorners.size();
+
+		// Angle weighted sum per position. If every face around a position is within half the crease angle of it, every
+		// pair of them is within the crease angle and the smooth normal is the answer; only the rest are creased.
+		const float CosHalfCrease = cosf(ToRadians(min(CreaseAngleDegrees, 180.0f) * 0.5f));
+		const float CosCrease = cosf(ToRadians(min(CreaseAngleDegrees, 180.0f)));
+		std::vector<FVector3> SmoothNormals(NumVs);
+		std::vector<uint8> bCreased(NumVs, 0);
+		RunOnThreads(NumThreads,
+			[&](uint32 ThreadIndex)
+			{
+				const uint32 Begin = (uint32)((uint64)NumVs * ThreadIndex / NumThreads);
+				const uint32 End = (uint32)((uint64)NumVs * (ThreadIndex + 1) / NumThreads);
+				for (uint32 Pos = Begin; Pos < End; ++Pos)
+				{
+					FVector3 Sum = FVector3::GetZero();
+					for (uint32 Index = CornerOffsets[Pos]; Index < CornerOffsets[Pos + 1]; ++Index)
+					{
+						const uint32 Corner = PosCorners[Index];
+						Sum = Sum.Add(FaceNormals[Corner / 3].Mul(CornerAngles[Corner]));
+					}
+					SmoothNormals[Pos] = Sum.GetNormalized();
+
+					if (CreaseAngleDegrees < 180.0f)
+					{
+						for (uint32 Index = CornerOffsets[Pos]; Index < CornerOffsets[Pos + 1]; ++Index)
+						{
+							// Degenerate faces don't have a side of the crease
+							const FVector3& FaceNormal = FaceNormals[PosCorners[Index] / 3];
+							if (FaceNormal.Dot(FaceNormal) > 0 && FaceNormal.Dot(SmoothNormals[Pos]) < CosHalfCrease)
+							{
+								bCreased[Pos] = 1;
+								break;
+							}
+						}
+					}
+				}
+			});
+
+		// The normals each position adds are numbered in the order its corners first need them and kept in the position's
+		// own range of PosCorners, as it never needs more than it has corners; CornerNormals has the number each corner
+		// gets, or NO_NORMAL if it had one. At creased positions faces are joined into smoothing groups across the edges
+		// they share there when their normals are within the crease angle (union-find over the fan), so a group is a part
+		// of the fan that doesn't cross a crease. Degenerate faces take the smooth normal.
+		const uint32 NO_NORMAL = (uint32)-1;
+		std::vector<FVector3> NewNormals(PosCorners.size());
+		std::vector<uint32> CornerNormals(PosCorners.size());
+		std::vector<uint32> NewNormalOffsets(NumVs + 1, 0);
+		RunOnThreads(NumThreads,
+			[&](uint32 ThreadIndex)
+			{
+				// Per fan: union-find parents, the face normals, the other two positions of each face (NO_NORMAL if the face
+				// is degenerate), the number of each group's normal at its root, and for big fans
+				// (other end << 32 | fan corner) for each edge at the position
+				std::vector<uint32> Parents;
+				std::vector<FVector3> Normals;
+				std::vector<uint32> Ends;
+				std::vector<uint32> GroupNormals;
+				std::vector<uint64> Edges;
+				auto Find = [&](uint32 Local)
+				{
+					while (Parents[Local] != Local)
+					{
+						Parents[Local] = Parents[Parents[Local]];
+						Local = Parents[Local];
+					}
+					return Local;
+				};
+				auto Join = [&](uint32 A, uint32 B)
+				{
+					if (Normals[A].Dot(Normals[B]) >= CosCrease)
+					{
+						Parents[Find(A)] = Find(B);
+					}
+				};
+
+				const uint32 Begin = (uint32)((uint64)NumVs * ThreadIndex / NumThreads);
+				const uint32 End = (uint32)((uint64)NumVs * (ThreadIndex + 1) / NumThreads);
+				for (uint32 Pos = Begin; Pos < End; ++Pos)
+				{
+					const uint32 First = CornerOffsets[Pos];
+					const uint32 NumFanCorners = CornerOffsets[Pos + 1] - First;
+					const bool bCreasedPos = bCreased[Pos] != 0;
+					if (bCreasedPos)
+					{
+						Parents.resize(NumFanCorners);
+						Normals.resize(NumFanCorners);
+						Ends.resize(NumFanCorners * 2);
+						for (uint32 Local = 0; Local < NumFanCorners; ++Local)
+						{
+							const uint32 Corner = PosCorners[First + Local];
+							Parents[Local] = Local;
+							Normals[Local] = FaceNormals[Corner / 3];
+
+							// Every corner of a face with a normal is valid
+							const bool bValid = Normals[Local].Dot(Normals[Local]) > 0;
+							const FFace& Face = Obj.Faces[Corner / 3];
+							Ends[Local * 2 + 0] = bValid ? (uint32)Face.Corners[(Corner + 1) % 3].Pos : NO_NORMAL;
+							Ends[Local * 2 + 1] = bValid ? (uint32)Face.Corners[(Corner + 2) % 3].Pos : NO_NORMAL - 1;
+						}
+
+						// Faces sharing an edge at the position share its other end; more than two on an edge is a non
+						// manifold edge. Small fans compare every pair, big ones sort the edges so they're next to each other.
+						if (NumFanCorners <= 16)
+						{
+							for (uint32 A = 0; A < NumFanCorners; ++A)
+							{
+								const uint32 EndA0 = Ends[A * 2 + 0];
+								const uint32 EndA1 = Ends[A * 2 + 1];
+								if (EndA0 == NO_NORMAL)
+								{
+									continue;
+								}
+								for (uint32 B = A + 1; B < NumFanCorners; ++B)
+								{
+									const uint32 EndB0 = Ends[B * 2 + 0];
+									const uint32 EndB1 = Ends[B * 2 + 1];
+									if ((EndA0 == EndB0) | (EndA0 == EndB1) | (EndA1 == EndB0) | (EndA1 == EndB1))
+									{
+										Join(A, B);
+									}
+								}
+							}
+						}
+						else
+						{
+							Edges.clear();
+							for (uint32 Local = 0; Local < NumFanCorners; ++Local)
+							{
+								if (Ends[Local * 2] != NO_NORMAL)
+								{
+									Edges.push_back(((uint64)Ends[Local * 2 + 0] << 32) | Local);
+									Edges.push_back(((uint64)Ends[Local * 2 + 1] << 32) | Local);
+								}
+							}
+							std::sort(Edges.begin(), Edges.end());
+							for (uint32 A = 0; A < (uint32)Edges.size(); ++A)
+							{
+								for (uint32 B = A + 1; B < (uint32)Edges.size() && (Edges[A] >> 32) == (Edges[B] >> 32); ++B)
+								{
+									Join((uint32)Edges[A], (uint32)Edges[B]);
+								}
+							}
+						}
+						GroupNormals.assign(NumFanCorners, NO_NORMAL);
+					}
+
+					uint32 NumNormals = 0;
+					uint32 SmoothNormal = NO_NORMAL;
+					for (uint32 Local = 0; Local < NumFanCorners; ++Local)
+					{
+						const uint32 Corner = PosCorners[First + Local];
+						uint32& Normal = CornerNormals[First + Local];
+						if (Obj.Faces[Corner / 3].Corners[Corner % 3].Normal != -1)
+						{
+							Normal = NO_NORMAL;
+						}
+						else if (bCreasedPos && Ends[Local * 2] != NO_NORMAL)
+						{
+							uint32& GroupNormal = GroupNormals[Find(Local)];
+							if (GroupNormal == NO_NORMAL)
+							{
+								GroupNormal = NumNormals++;
+								NewNormals[First + GroupNormal] = FVector3::GetZero();
+							}
+							Normal = GroupNormal;
+						}
+						else
+						{
+							if (SmoothNormal == NO_NORMAL)
+							{
+								SmoothNormal = NumNormals++;
+								NewNormals[First + SmoothNormal] = SmoothNormals[Pos];
+							}
+							Normal = SmoothNormal;
+						}
+					}
+
+					// Groups average all of their faces, also the ones whose corners had a normal
+					if (bCreasedPos)
+					{
+						for (uint32 Local = 0; Local < NumFanCorners; ++Local)
+						{
+							const uint32 GroupNormal = Ends[Local * 2] != NO_NORMAL ? GroupNormals[Find(Local)] : NO_NORMAL;
+							if (GroupNormal != NO_NORMAL)
+							{
+								FVector3& Sum = NewNormals[First + GroupNormal];
+								Sum = Sum.Add(Normals[Local].Mul(CornerAngles[PosCorners[First + Local]]));
+							}
+						}
+						for (uint32 Local = 0; Local < NumFanCorners; ++Local)
+						{
+							if (Parents[Local] == Local && GroupNormals[Local] != NO_NORMAL)
+							{
+								NewNormals[First + GroupNormals[Local]] = NewNormals[First + GroupNormals[Local]].GetNormalized();
+							}
+						}
+					}
+					NewNormalOffsets[Pos] = NumNormals;
+				}
+			});
+
+		// Counts to offsets, then every position copies its normals to their final place and points its corners at them
+		uint32 NumNewNormals = 0;
+		for (uint32 Pos = 0; Pos <= NumVs; ++Pos)
+		{
+			const uint32 Count = NewNormalOffsets[Pos];
+			NewNormalOffsets[Pos] = NumNewNormals;
+			NumNewNormals += Count;
+		}
+		const uint32 FirstVN = (uint32)Obj.VNs.size();
+		Obj.VNs.resize(FirstVN + NumNewNormals);
+		RunOnThreads(NumThreads,
+			[&](uint32 ThreadIndex)
+			{
+				const uint32 Begin = (uint32)((uint64)NumVs * ThreadIndex / NumThreads);
+				const uint32 End = (uint32)((uint64)NumVs * (ThreadIndex + 1) / NumThreads);
+				for (uint32 Pos = Begin; Pos < End; ++Pos)
+				{
+					const uint32 First = CornerOffsets[Pos];
+					const uint32 Offset = FirstVN + NewNormalOffsets[Pos];
+					for (uint32 Index = 0; Index < NewNormalOffsets[Pos + 1] - NewNormalOffsets[Pos]; ++Index)
+					{
+						Obj.VNs[Offset + Index] = NewNormals[First + Index];
+					}
+					for (uint32 Index = First; Index < CornerOffsets[Pos + 1]; ++Index)
+					{
+						if (CornerNormals[Index] != NO_NORMAL)
+						{
+							Obj.Faces[PosCorners[Index] / 3].Corners[PosCorners[Index] % 3].Normal = (int32)(Offset + CornerNormals[Index]);
+						}
+					}
+				}
+			});
+	}
+
+	static inline uint32 HashCorner(const FFace::FCorner& Corner)
+	{
+		uint32 Hash = (uint32)Corner.Pos * 0x9e3779b1u;
+		Hash = (Hash ^ (uint32)Corner.UV) * 0x85ebca6bu;
+		Hash = (Hash ^ (uint32)Corner.Normal) * 0xc2b2ae35u;
+		return Hash ^ (Hash >> 16);
+	}
+
+	void BuildIndexedMesh(const FObj& Obj, FIndexedMesh& OutMesh)
+	{
+		const uint32 NumCorners = (uint32)Obj.Faces.size() * 3;
+		OutMesh.Vertices.clear();
+		OutMesh.Indices.resize(NumCorners);
+
+		// Open addressing table of vertex indices; corners are unique if their three indices are
+		std::vector<FFace::FCorner> Unique;
+		uint32 TableSize = 16;
+		while (TableSize < NumCorners * 2)
+		{
+			TableSize *= 2;
+		}
+		std::vector<uint32> Table(TableSize, (uint32)-1);
+
+		for (uint32 Index = 0; Index < NumCorners; ++Index)
+		{
+			const FFace::FCorner& Corner = Obj.Faces[Index / 3].Corners[Index % 3];
+			uint32 Slot = HashCorner(Corner) & (TableSize - 1);
+			while (true)
+			{
+				uint32 Found = Table[Slot];
+				if (Found == (uint32)-1)
+				{
+					Found = (uint32)Unique.size();
+					Table[Slot] = Found;
+					Unique.push_back(Corner);
+					OutMesh.Indices[Index] = Found;
+					break;
+				}
+				else if (!memcmp(&Unique[Found], &Corner, sizeof(Corner)))
+				{
+					OutMesh.Indices[Index] = Found;
+					break;
+				}
+				Slot = (Slot + 1) & (TableSize - 1);
+			}
+		}
+
+		OutMesh.Sections.clear();
+		for (auto& Range : Obj.MaterialRanges)
+		{
+			FMeshSection Section = {Range.Material, Range.FirstFace * 3, Range.NumFaces * 3};
+			OutMesh.Sections.push_back(Section);
+		}
+
+		OutMesh.Vertices.resize(Unique.size());
+		for (uint32 Index = 0; Index < (uint32)Unique.size(); ++Index)
+		{
+			const FFace::FCorner& Corner = Unique[Index];
+			FMeshVertex& Vertex = OutMesh.Vertices[Index];
+			Vertex.Pos = (uint32)Corner.Pos < Obj.Vs.size() ? Obj.Vs[Corner.Pos] : FVector3::GetZero();
+			Vertex.Normal = (uint32)Corner.Normal < Obj.VNs.size() ? Obj.VNs[Corner.Normal] : FVector3::GetZero();
+			Vertex.UV = (uint32)Corner.UV < Obj.VTs.size() ? Obj.VTs[Corner.UV] : FVector2::GetZero();
+		}
+	}
+
+	enum
+	{
+		CACHE_MAGIC = 0x4e49424f,	// 'OBIN'
+
+		// Bump when the layout or the contents of the cache change
+		CACHE_VERSION = 10,
+	};
+
+	struct FCacheHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+
+		// Source .obj
+		uint64 SourceSize;
+		uint64 SourceTime;
+		uint64 SourceHash;
+
+		uint32 VertexStride;
+		uint32 NumVertices;
+		uint32 IndexStride;
+		uint32 NumIndices;
+		uint32 NumSections;
+		uint32 Padding;
+		uint64 VerticesOffset;
+		uint64 IndicesOffset;
+		uint64 SectionsOffset;
+		uint64 PayloadHash;
+		FVertexQuantization Quantization;
+		FMeshBounds Bounds;
+
+		// HashCacheHeader()
+		uint64 HeaderHash;
+	};
+
+	// Everything but the fields written after the rest: the magic, SourceTime (UpdateCacheSourceTime()) and the hashes
+	static uint64 HashCacheHeader(FCacheHeader Header)
+	{
+		Header.Magic = 0;
+		Header.SourceTime = 0;
+		Header.PayloadHash = 0;
+		Header.HeaderHash = 0;
+		return HashMemory(&Header, sizeof(Header));
+	}
+
+	static std::string GetCacheFilename(const char* ObjFilename)
+	{
+		return std::string(ObjFilename) + "bin";
+	}
+
+	static bool GetSourceSizeAndTime(const char* Filename, uint64& OutSize, uint64& OutTime)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA Data;
+		if (!::GetFileAttributesExA(Filename, GetFileExInfoStandard, &Data))
+		{
+			return false;
+		}
+
+		OutSize = ((uint64)Data.nFileSizeHigh << 32) | Data.nFileSizeLow;
+		OutTime = ((uint64)Data.ftLastWriteTime.dwHighDateTime << 32) | Data.ftLastWriteTime.dwLowDateTime;
+		return true;
+	}
+
+	static bool HashSource(const char* Filename, uint64& OutHash)
+	{
+		FMappedFile File;
+		if (!File.Open(Filename))
+		{
+			return false;
+		}
+
+		OutHash = HashMemory(File.GetData(), File.GetSize());
+		File.Close();
+		return true;
+	}
+
+	// Stores a new source time in an existing cache's header; the payload hash doesn't cover it
+	static bool UpdateCacheSourceTime(const char* ObjFilename, uint64 SourceTime)
+	{
+		FILE* File = nullptr;
+		fopen_s(&File, GetCacheFilename(ObjFilename).c_str(), "r+b");
+		if (!File)
+		{
+			return false;
+		}
+
+		bool bOk = fseek(File, offsetof(FCacheHeader, SourceTime), SEEK_SET) == 0;
+		bOk = bOk && fwrite(&SourceTime, sizeof(SourceTime), 1, File) == 1;
+		fclose(File);
+		return bOk;
+	}
+
+	static bool LoadCache(const char* ObjFilename, uint32 VertexStride, FCachedMesh& OutMesh, bool bUpdateSourceTime)
+	{
+		uint64 SourceSize = 0;
+		uint64 SourceTime = 0;
+		if (!GetSourceSizeAndTime(ObjFilename, SourceSize, SourceTime))
+		{
+			return false;
+		}
+
+		FMappedFile& File = OutMesh.File;
+		if (!File.Open(GetCacheFilename(ObjFilename).c_str()))
+		{
+			return false;
+		}
+
+		auto Fail = [&]()
+		{
+			OutMesh.Close();
+			return false;
+		};
+
+		if (File.GetSize() < sizeof(FCacheHeader))
+		{
+			return Fail();
+		}
+
+		FCacheHeader Header;
+		memcpy(&Header, File.GetData(), sizeof(Header));
+		if (Header.Magic != CACHE_MAGIC || Header.Version != CACHE_VERSION || Header.HeaderHash != HashCacheHeader(Header) ||
+			Header.VertexStride != VertexStride || Header.SourceSize != SourceSize)
+		{
+			return Fail();
+		}
+
+		const uint64 VerticesSize = (uint64)Header.NumVertices * Header.VertexStride;
+		const uint64 IndicesSize = (uint64)Header.NumIndices * Header.IndexStride;
+		const uint64 SectionsSize = (uint64)Header.NumSections * sizeof(FMeshSection);
+		if (Header.VerticesOffset < sizeof(FCacheHeader) || Header.VerticesOffset + VerticesSize > File.GetSize() ||
+			Header.IndicesOffset < Header.VerticesOffset + VerticesSize || Header.IndicesOffset + IndicesSize > File.GetSize() ||
+			Header.SectionsOffset < Header.IndicesOffset + IndicesSize || Header.SectionsOffset + SectionsSize != File.GetSize())
+		{
+			return Fail();
+		}
+
+		if (Header.SourceTime != SourceTime)
+		{
+			// Touched but maybe not modified (eg a fresh sync), so check the contents
+			uint64 SourceHash = 0;
+			if (!HashSource(ObjFilename, SourceHash) || SourceHash != Header.SourceHash)
+			{
+				return Fail();
+			}
+
+			// Same contents, so store the new time and the next load won't hash the source again. The cache is mapped
+			// without write sharing, so it's patched in between and loaded again, this time without updating.
+			if (bUpdateSourceTime)
+			{
+				OutMesh.Close();
+				UpdateCacheSourceTime(ObjFilename, SourceTime);
+				return LoadCache(ObjFilename, VertexStride, OutMesh, false);
+			}
+		}
+
+		const char* Payload = File.GetData() + Header.VerticesOffset;
+		if (HashMemory(Payload, File.GetSize() - Header.VerticesOffset) != Header.PayloadHash)
+		{
+			return Fail();
+		}
+
+		OutMesh.VertexStride = Header.VertexStride;
+		OutMesh.NumVertices = Header.NumVertices;
+		OutMesh.Vertices = File.GetData() + Header.VerticesOffset;
+		OutMesh.IndexStride = Header.IndexStride;
+		OutMesh.NumIndices = Header.NumIndices;
+		OutMesh.Indices = Header.NumIndices ? File.GetData() + Header.IndicesOffset : nullptr;
+		OutMesh.NumSections = Header.NumSections;
+		OutMesh.Sections = Header.NumSections ? (const FMeshSection*)(File.GetData() + Header.SectionsOffset) : nullptr;
+		OutMesh.Quantization = Header.Quantization;
+		OutMesh.Bounds = Header.Bounds;
+		return true;
+	}
+
+	bool LoadCache(const char* ObjFilename, uint32 VertexStride, FCachedMesh& OutMesh)
+	{
+		return LoadCache(ObjFilename, VertexStride, OutMesh, true);
+	}
+
+	bool SaveCache(const char* ObjFilename, const void* Vertices, uint32 VertexStride, uint32 NumVertices, const void* Indices, uint32 IndexStride, uint32 NumIndices, const FMeshSection* Sections, uint32 NumSections, const FMeshBounds& Bounds, const FVertexQuantization& Quantization)
+	{
+		FCacheHeader Header;
+		MemZero(Header);
+		Header.Version = CACHE_VERSION;
+		if (!GetSourceSizeAndTime(ObjFilename, Header.SourceSize, Header.SourceTime) || !HashSource(ObjFilename, Header.SourceHash))
+		{
+			return false;
+		}
+
+		Header.VertexStride = VertexStride;
+		Header.NumVertices = NumVertices;
+		Header.IndexStride = NumIndices ? IndexStride : 0;
+		Header.NumIndices = NumIndices;
+		const uint64 VerticesSize = (uint64)NumVertices * VertexStride;
+		const uint64 IndicesSize = (uint64)Header.NumIndices * Header.IndexStride;
+		Header.NumSections = NumSections;
+		const uint64 SectionsSize = (uint64)NumSections * sizeof(FMeshSection);
+		Header.VerticesOffset = Align((uint64)sizeof(FCacheHeader), (uint64)16);
+		Header.IndicesOffset = Align(Header.VerticesOffset + VerticesSize, (uint64)16);
+		Header.SectionsOffset = Align(Header.IndicesOffset + IndicesSize, (uint64)16);
+		Header.Quantization = Quantization;
+		Header.Bounds = Bounds;
+
+		std::vector<char> Payload(Header.SectionsOffset - Header.VerticesOffset + SectionsSize, 0);
+		if (VerticesSize)
+		{
+			memcpy(&Payload[0], Vertices, VerticesSize);
+		}
+		if (IndicesSize)
+		{
+			memcpy(&Payload[Header.IndicesOffset - Header.VerticesOffset], Indices, IndicesSize);
+		}
+		if (SectionsSize)
+		{
+			memcpy(&Payload[Header.SectionsOffset - Header.VerticesOffset], Sections, SectionsSize);
+		}
+		Header.PayloadHash = HashMemory(Payload.data(), Payload.size());
+		Header.HeaderHash = HashCacheHeader(Header);
+
+		FILE* File = nullptr;
+		fopen_s(&File, GetCacheFilename(ObjFilename).c_str(), "wb");
+		if (!File)
+		{
+			return false;
+		}
+
+		// Write the magic last so a partially written file is never picked up
+		char Padding[16] = {0};
+		bool bOk = fwrite(&Header, sizeof(Header), 1, File) == 1;
+		bOk = bOk && fwrite(Padding, 1, Header.VerticesOffset - sizeof(Header), File) == Header.VerticesOffset - sizeof(Header);
+		bOk = bOk && (Payload.empty() || fwrite(Payload.data(), 1, Payload.size(), File) == Payload.size());
+		if (bOk)
+		{
+			fflush(File);
+			Header.Magic = CACHE_MAGIC;
+			fseek(File, 0, SEEK_SET);
+			bOk = fwrite(&Header.Magic, sizeof(Header.Magic), 1, File) == 1;
+		}
+		fclose(File);
+
+		return bOk;
+	}
 }
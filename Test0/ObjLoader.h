@@ -1,9 +1,14 @@
 #pragma once
 
+#include "Mesh.h"
+#include <string>
+
 namespace Obj
 {
+	// Polygons are triangulated while loading, so every face is a triangle
 	struct FFace
 	{
+		// 0 based indices into FObj's arrays; -1 if the corner doesn't have that attribute
 		struct FCorner
 		{
 			int32 Pos;
@@ -13,13 +18,173 @@ namespace Obj
 		FCorner Corners[3];
 	};
 
+	// From newmtl blocks in the mtllib files; only the properties we know about
+	struct FMaterial
+	{
+		std::string Name;
+		FVector3 Ambient = {{{1, 1, 1}}};		// Ka
+		FVector3 Diffuse = {{{1, 1, 1}}};		// Kd
+		FVector3 Specular = {{{0, 0, 0}}};		// Ks
+		FVector3 Emissive = {{{0, 0, 0}}};		// Ke
+		float SpecularExponent = 0;				// Ns
+		float Opacity = 1;						// d, or 1 - Tr
+		uint32 IlluminationModel = 0;			// illum
+
+		// map_Kd, relative to the .mtl
+		std::string DiffuseTexture;
+	};
+
+	struct FMaterialRange
+	{
+		uint32 Material;
+		uint32 FirstFace;
+		uint32 NumFaces;
+	};
+
 	struct FObj
 	{
 		std::vector<FVector3> Vs;
 		std::vector<FVector2> VTs;
 		std::vector<FVector3> VNs;
 		std::vector<FFace> Faces;
+
+		std::vector<std::string> MaterialLibraries;
+		std::vector<FMaterial> Materials;
+
+		// After Load() faces are sorted by material, so there is one range per used material
+		std::vector<FMaterialRange> MaterialRanges;
+	};
+
+	enum class ELoadMode
+	{
+		// fgets() one line at a time
+		Lines,
+
+		// Map the whole file and parse in place
+		Mapped,
+
+		// Map the whole file and parse chunks of lines on worker threads, then stitch them together
+		Parallel,
+	};
+
+	struct FLoadStats
+	{
+		// From the counting pass that sizes the arrays before parsing; it doesn't run for ELoadMode::Lines
+		uint64 NumCountedVs = 0;
+		uint64 NumCountedVTs = 0;
+		uint64 NumCountedVNs = 0;
+		uint64 NumCountedTriangles = 0;
+
+		// Array allocations while loading, and how many of those were a push_back outgrowing its capacity
+		// (0 means the counting pass was exact). Sorting faces by material adds one if a material's faces are split up.
+		uint32 NumAllocations = 0;
+		uint32 NumGrowths = 0;
+
+		// Bytes held by the arrays when done, and at most at once (the parallel loader keeps its chunks while stitching)
+		uint64 FinalBytes = 0;
+		uint64 PeakBytes = 0;
+
+		// Whole process, from GetProcessMemoryInfo()
+		uint64 PeakWorkingSetBytes = 0;
+		uint64 PeakPrivateBytes = 0;
+	};
+
+	// The number parser used for v/vt/vn: skips leading blanks and leaves Line after the number. Correctly rounded and
+	// independent of the current locale, so it must match strtof() in the "C" locale bit for bit.
+	float ReadFloat(const char*& Line);
+
+	// NumThreads is only used by ELoadMode::Parallel; 0 means one per core
+	bool Load(const char* Filename, FObj& OutObj, ELoadMode Mode = ELoadMode::Mapped, uint32 NumThreads = 0, FLoadStats* OutStats = nullptr);
+
+	// Triangles handed out by LoadStreaming(); valid during the callback only
+	struct FStreamBatch
+	{
+		// Three vertices per triangle
+		const FMeshVertex* Vertices;
+		uint32 NumTriangles;
+
+		// From the last usemtl, empty if none; a batch never spans two materials
+		const char* Material;
+	};
+
+	struct FStreamStats
+	{
+		uint64 NumTriangles = 0;
+		uint32 NumBatches = 0;
+
+		// Attribute blocks that had been evicted and were read back from the file
+		uint64 NumBlockReloads = 0;
+
+		// Memory owned by the loader
+		uint64 PeakLoaderBytes = 0;
+
+		// Whole process, from GetProcessMemoryInfo()
+		uint64 PeakWorkingSetBytes = 0;
+		uint64 PeakPrivateBytes = 0;
+	};
+
+	typedef void (*FStreamBatchFunction)(const FStreamBatch& Batch, void* UserData);
+
+	// Reads the file in fixed size pieces and calls Function with every TrianglesPerBatch triangles, without keeping the
+	// mesh around. Positions/uvs/normals are kept in a bounded cache of blocks which are parsed again from the file
+	// if a face refers to an evicted one, so memory only grows by a few bytes per thousand vertices.
+	// mtllib is ignored; usemtl only names the batches.
+	bool LoadStreaming(const char* Filename, uint32 TrianglesPerBatch, FStreamBatchFunction Function, void* UserData, FStreamStats* OutStats = nullptr);
+
+	template <typename TBatchLambda>
+	inline bool LoadStreaming(const char* Filename, uint32 TrianglesPerBatch, TBatchLambda Lambda, FStreamStats* OutStats = nullptr)
+	{
+		auto Function = [](const FStreamBatch& Batch, void* UserData)
+		{
+			(*(TBatchLambda*)UserData)(Batch);
+		};
+		return LoadStreaming(Filename, TrianglesPerBatch, (FStreamBatchFunction)Function, &Lambda, OutStats);
+	}
+
+	// Gives every corner without a normal the angle weighted average of the faces around its position (180 for fully
+	// smooth). Below 180, faces around a position that share an edge there and are within CreaseAngleDegrees of each other
+	// join the same smoothing group, and each group is averaged on its own. Positions are split across NumThreads threads
+	// (0 means one per core).
+	void GenerateNormals(FObj& Obj, float CreaseAngleDegrees, uint32 NumThreads = 0);
+
+	// Welds face corners sharing the same position/uv/normal indices into one vertex
+	void BuildIndexedMesh(const FObj& Obj, FIndexedMesh& OutMesh);
+
+	// Final vertex/index streams stored next to the .obj (as .objbin) so later runs can skip parsing entirely.
+	// Vertices and Indices point into the mapped cache file and are valid until Close().
+	struct FCachedMesh
+	{
+		FMappedFile File;
+
+		const void* Vertices = nullptr;
+		uint32 VertexStride = 0;
+		uint32 NumVertices = 0;
+
+		// IndexStride is 0 for non indexed meshes
+		const void* Indices = nullptr;
+		uint32 IndexStride = 0;
+		uint32 NumIndices = 0;
+
+		const FMeshSection* Sections = nullptr;
+		uint32 NumSections = 0;
+
+		// How to get back positions from quantized vertices; identity for float vertices
+		FVertexQuantization Quantization = FVertexQuantization::GetIdentity();
+
+		// From the float positions before any quantization
+		FMeshBounds Bounds;
+
+		void Close()
+		{
+			File.Close();
+			Vertices = nullptr;
+			Indices = nullptr;
+			Sections = nullptr;
+		}
 	};
 
-	bool Load(const char* Filename, FObj& OutObj);
+	// Returns false if there is no cache or it's stale (source .obj changed) or corrupt. A source that was only touched is
+	// hashed once and its new time stored in the cache.
+	bool LoadCache(const char* ObjFilename, uint32 VertexStride, FCachedMesh& OutMesh);
+	bool SaveCache(const char* ObjFilename, const void* Vertices, uint32 VertexStride, uint32 NumVertices, const void* Indices, uint32 IndexStride, uint32 NumIndices, const FMeshSection* Sections, uint32 NumSections, const FMeshBounds& Bounds, const FVertexQuantization& Quantization = FVertexQuantization::GetIdentity());
 }
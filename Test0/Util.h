@@ -1,27 +1,18 @@
 #pragma once
 
+#include "Core.h"
 #include <vector>
 #include <list>
 #include <map>
 #include <algorithm>
-
-typedef uint8_t uint8;
-typedef uint32_t uint32;
-typedef int32_t int32;
-typedef uint64_t uint64;
-typedef int64_t int64;
-
-#define check(x) if (!(x)) __debugbreak();
+#include <float.h>
+#if ENABLE_SIMD
+#include <xmmintrin.h>
+#endif
 
 #define checkD3D12(r) do { HRESULT hr = r; check(SUCCEEDED(hr)); hr = hr; } while (0)
 
 
-template <typename T>
-inline void MemZero(T& Struct)
-{
-	ZeroMemory(&Struct, sizeof(T));
-}
-
 inline std::vector<char> LoadFile(const char* Filename)
 {
 	std::vector<char> Data;
@@ -45,16 +36,155 @@ inline std::vector<char> LoadFile(const char* Filename)
 	return Data;
 }
 
-inline bool IsPowerOfTwo(uint64 N)
+// Read-only view of a whole file; avoids copying large assets into a std::vector
+struct FMappedFile
 {
-	return (N != 0) && !(N & (N - 1));
+	bool Open(const char* Filename)
+	{
+		File = ::CreateFileA(Filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (File == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER FileSize;
+		::GetFileSizeEx(File, &FileSize);
+		Size = (uint64)FileSize.QuadPart;
+		if (Size == 0)
+		{
+			// Can't map an empty file
+			return true;
+		}
+
+		Mapping = ::CreateFileMappingA(File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!Mapping)
+		{
+			Close();
+			return false;
+		}
+
+		Data = (const char*)::MapViewOfFile(Mapping, FILE_MAP_READ, 0, 0, 0);
+		if (!Data)
+		{
+			Close();
+			return false;
+		}
+
+		return true;
+	}
+
+	void Close()
+	{
+		if (Data)
+		{
+			::UnmapViewOfFile(Data);
+			Data = nullptr;
+		}
+
+		if (Mapping)
+		{
+			::CloseHandle(Mapping);
+			Mapping = nullptr;
+		}
+
+		if (File != INVALID_HANDLE_VALUE)
+		{
+			::CloseHandle(File);
+			File = INVALID_HANDLE_VALUE;
+		}
+		Size = 0;
+	}
+
+	const char* GetData() const
+	{
+		return Data;
+	}
+
+	uint64 GetSize() const
+	{
+		return Size;
+	}
+
+	HANDLE File = INVALID_HANDLE_VALUE;
+	HANDLE Mapping = nullptr;
+	const char* Data = nullptr;
+	uint64 Size = 0;
+};
+
+// Fast non cryptographic hash, 8 bytes per step
+inline uint64 HashMemory(const void* Data, uint64 Size, uint64 Hash = 0xcbf29ce484222325ull)
+{
+	const uint64 Multiplier = 0x9e3779b97f4a7c15ull;
+	const uint8* Bytes = (const uint8*)Data;
+	const uint64 NumWords = Size / 8;
+	for (uint64 Index = 0; Index < NumWords; ++Index)
+	{
+		uint64 Word;
+		memcpy(&Word, Bytes + Index * 8, sizeof(Word));
+		Hash = (Hash ^ Word) * Multiplier;
+		Hash ^= Hash >> 29;
+	}
+
+	for (uint64 Index = NumWords * 8; Index < Size; ++Index)
+	{
+		Hash = (Hash ^ Bytes[Index]) * Multiplier;
+		Hash ^= Hash >> 29;
+	}
+
+	return Hash ^ Size;
 }
 
-template <typename T>
-inline T Align(T Value, T Alignment)
+inline uint32 GetNumberOfCores()
 {
-	check(IsPowerOfTwo(Alignment));
-	return (Value + (Alignment - 1)) & ~(Alignment - 1);
+	SYSTEM_INFO Info;
+	::GetSystemInfo(&Info);
+	return max((uint32)Info.dwNumberOfProcessors, 1u);
+}
+
+inline double GetTimeInMs()
+{
+	LARGE_INTEGER Frequency;
+	LARGE_INTEGER Counter;
+	::QueryPerformanceFrequency(&Frequency);
+	::QueryPerformanceCounter(&Counter);
+	return (double)Counter.QuadPart * 1000.0 / (double)Frequency.QuadPart;
+}
+
+// Runs Func(ThreadIndex) on NumThreads threads (the calling thread being index 0) and waits for all of them
+template <typename TFunc>
+inline void RunOnThreads(uint32 NumThreads, TFunc Func)
+{
+	struct FTask
+	{
+		TFunc* Func;
+		uint32 Index;
+
+		static DWORD __stdcall ThreadFunction(void* Param)
+		{
+			auto* This = (FTask*)Param;
+			(*This->Func)(This->Index);
+			return 0;
+		}
+	};
+
+	std::vector<FTask> Tasks(NumThreads);
+	std::vector<HANDLE> Threads;
+	for (uint32 Index = 1; Index < NumThreads; ++Index)
+	{
+		Tasks[Index].Func = &Func;
+		Tasks[Index].Index = Index;
+		HANDLE Thread = ::CreateThread(nullptr, 0, FTask::ThreadFunction, &Tasks[Index], 0, nullptr);
+		check(Thread);
+		Threads.push_back(Thread);
+	}
+
+	Func(0);
+
+	for (HANDLE Thread : Threads)
+	{
+		::WaitForSingleObject(Thread, INFINITE);
+		::CloseHandle(Thread);
+	}
 }
 
 inline float ToRadians(float Deg)
@@ -129,6 +259,50 @@ struct FVector3
 		V.z = z * I.z;
 		return V;
 	}
+
+	FVector3 Add(const FVector3& I) const
+	{
+		FVector3 V;
+		V.x = x + I.x;
+		V.y = y + I.y;
+		V.z = z + I.z;
+		return V;
+	}
+
+	FVector3 Sub(const FVector3& I) const
+	{
+		FVector3 V;
+		V.x = x - I.x;
+		V.y = y - I.y;
+		V.z = z - I.z;
+		return V;
+	}
+
+	float Dot(const FVector3& I) const
+	{
+		return x * I.x + y * I.y + z * I.z;
+	}
+
+	FVector3 Cross(const FVector3& I) const
+	{
+		FVector3 V;
+		V.x = y * I.z - z * I.y;
+		V.y = z * I.x - x * I.z;
+		V.z = x * I.y - y * I.x;
+		return V;
+	}
+
+	float Length() const
+	{
+		return sqrt(Dot(*this));
+	}
+
+	// Zero stays zero
+	FVector3 GetNormalized() const
+	{
+		float Len = Length();
+		return Len > 0 ? Mul(1.0f / Len) : *this;
+	}
 };
 
 struct FVector4
@@ -165,6 +339,173 @@ struct FVector4
 	}
 };
 
+#if ENABLE_SIMD
+// _MM_SHUFFLE() with the lanes in memory order
+#define SIMD_SHUFFLE(A, B, X, Y, Z, W)	_mm_shuffle_ps(A, B, _MM_SHUFFLE(W, Z, Y, X))
+#define SIMD_SWIZZLE(V, X, Y, Z, W)		SIMD_SHUFFLE(V, V, X, Y, Z, W)
+#endif
+
+struct FQuaternion
+{
+	float x, y, z, w;
+
+	static FQuaternion GetIdentity()
+	{
+		FQuaternion New = {0, 0, 0, 1};
+		return New;
+	}
+
+	// Rotation taking the x, y, z axes to X, Y, Z (orthonormal, right handed)
+	static FQuaternion FromAxes(const FVector3& X, const FVector3& Y, const FVector3& Z)
+	{
+		FQuaternion Q;
+		const float Trace = X.x + Y.y + Z.z;
+		if (Trace > 0)
+		{
+			const float S = 0.5f / sqrt(Trace + 1.0f);
+			Q.w = 0.25f / S;
+			Q.x = (Y.z - Z.y) * S;
+			Q.y = (Z.x - X.z) * S;
+			Q.z = (X.y - Y.x) * S;
+		}
+		else if (X.x > Y.y && X.x > Z.z)
+		{
+			const float S = 2.0f * sqrt(1.0f + X.x - Y.y - Z.z);
+			Q.w = (Y.z - Z.y) / S;
+			Q.x = 0.25f * S;
+			Q.y = (Y.x + X.y) / S;
+			Q.z = (Z.x + X.z) / S;
+		}
+		else if (Y.y > Z.z)
+		{
+			const float S = 2.0f * sqrt(1.0f + Y.y - X.x - Z.z);
+			Q.w = (Z.x - X.z) / S;
+			Q.x = (Y.x + X.y) / S;
+			Q.y = 0.25f * S;
+			Q.z = (Z.y + Y.z) / S;
+		}
+		else
+		{
+			const float S = 2.0f * sqrt(1.0f + Z.z - X.x - Y.y);
+			Q.w = (X.y - Y.x) / S;
+			Q.x = (Z.x + X.z) / S;
+			Q.y = (Z.y + Y.z) / S;
+			Q.z = 0.25f * S;
+		}
+		return Q;
+	}
+
+	float Length() const
+	{
+		return sqrt(x * x + y * y + z * z + w * w);
+	}
+
+	FQuaternion GetNormalized() const
+	{
+		const float Len = Length();
+		FQuaternion Q = {x / Len, y / Len, z / Len, w / Len};
+		return Len > 0 ? Q : GetIdentity();
+	}
+
+	FVector3 Rotate(const FVector3& V) const
+	{
+		// V + 2 * cross(q, cross(q, V) + w * V)
+		const FVector3 Q = {{{x, y, z}}};
+		const FVector3 T = Q.Cross(V).Add(V.Mul(w));
+		return V.Add(Q.Cross(T).Mul(2.0f));
+	}
+
+	// Counter clockwise looking down a unit Axis
+	static FQuaternion FromAxisAngle(const FVector3& Axis, float AngleRad)
+	{
+		const float Sin = sin(AngleRad * 0.5f);
+		const float Cos = cos(AngleRad * 0.5f);
+		FQuaternion Q = {Axis.x * Sin, Axis.y * Sin, Axis.z * Sin, Cos};
+		return Q;
+	}
+
+	float Dot(const FQuaternion& Q) const
+	{
+		return x * Q.x + y * Q.y + z * Q.z + w * Q.w;
+	}
+
+	// Inverse rotation for unit quaternions
+	FQuaternion GetConjugate() const
+	{
+		FQuaternion Q = {-x, -y, -z, w};
+		return Q;
+	}
+
+	// this * Q: rotates by Q first, then by this
+	FQuaternion Mul(const FQuaternion& Q) const
+	{
+#if ENABLE_SIMD
+		FQuaternion New;
+		_mm_storeu_ps(&New.x, MulSimd(_mm_loadu_ps(&x), _mm_loadu_ps(&Q.x)));
+		return New;
+#else
+		return MulScalar(Q);
+#endif
+	}
+
+	FQuaternion MulScalar(const FQuaternion& Q) const
+	{
+		FQuaternion New;
+		New.x = w * Q.x + x * Q.w + y * Q.z - z * Q.y;
+		New.y = w * Q.y - x * Q.z + y * Q.w + z * Q.x;
+		New.z = w * Q.z + x * Q.y - y * Q.x + z * Q.w;
+		New.w = w * Q.w - x * Q.x - y * Q.y - z * Q.z;
+		return New;
+	}
+
+	// Shortest arc; falls back to a normalized lerp when A and B are too close for acos
+	static FQuaternion Slerp(const FQuaternion& A, const FQuaternion& B, float Alpha)
+	{
+		float Cos = A.Dot(B);
+		const float Sign = Cos < 0 ? -1.0f : 1.0f;
+		Cos *= Sign;
+		float WeightA = 1.0f - Alpha;
+		float WeightB = Alpha * Sign;
+		if (Cos < 0.9995f)
+		{
+			const float Angle = acos(Cos);
+			const float InvSin = 1.0f / sin(Angle);
+			WeightA = sin(WeightA * Angle) * InvSin;
+			WeightB = sin(Alpha * Angle) * InvSin * Sign;
+		}
+		FQuaternion Q = {A.x * WeightA + B.x * WeightB, A.y * WeightA + B.y * WeightB, A.z * WeightA + B.z * WeightB, A.w * WeightA + B.w * WeightB};
+		return Cos < 0.9995f ? Q : Q.GetNormalized();
+	}
+
+#if ENABLE_SIMD
+	// Each of A's components times B's lanes in the order and signs of the Hamilton product
+	static __m128 MulSimd(__m128 A, __m128 B)
+	{
+		const __m128 SignsX = _mm_setr_ps(0.0f, -0.0f, 0.0f, -0.0f);
+		const __m128 SignsY = _mm_setr_ps(0.0f, 0.0f, -0.0f, -0.0f);
+		const __m128 SignsZ = _mm_setr_ps(-0.0f, 0.0f, 0.0f, -0.0f);
+		__m128 New = _mm_mul_ps(SIMD_SWIZZLE(A, 3, 3, 3, 3), B);
+		New = _mm_add_ps(New, _mm_xor_ps(_mm_mul_ps(SIMD_SWIZZLE(A, 0, 0, 0, 0), SIMD_SWIZZLE(B, 3, 2, 1, 0)), SignsX));
+		New = _mm_add_ps(New, _mm_xor_ps(_mm_mul_ps(SIMD_SWIZZLE(A, 1, 1, 1, 1), SIMD_SWIZZLE(B, 2, 3, 0, 1)), SignsY));
+		New = _mm_add_ps(New, _mm_xor_ps(_mm_mul_ps(SIMD_SWIZZLE(A, 2, 2, 2, 2), SIMD_SWIZZLE(B, 1, 0, 3, 2)), SignsZ));
+		return New;
+	}
+
+	static __m128 CrossSimd(__m128 A, __m128 B)
+	{
+		return _mm_sub_ps(_mm_mul_ps(SIMD_SWIZZLE(A, 1, 2, 0, 3), SIMD_SWIZZLE(B, 2, 0, 1, 3)), _mm_mul_ps(SIMD_SWIZZLE(A, 2, 0, 1, 3), SIMD_SWIZZLE(B, 1, 2, 0, 3)));
+	}
+
+	// Rotate() on V's xyz; w comes out as V's w
+	static __m128 RotateSimd(__m128 Q, __m128 V)
+	{
+		const __m128 T = _mm_add_ps(CrossSimd(Q, V), _mm_mul_ps(SIMD_SWIZZLE(Q, 3, 3, 3, 3), V));
+		const __m128 C = CrossSimd(Q, T);
+		return _mm_add_ps(V, _mm_add_ps(C, C));
+	}
+#endif
+};
+
 struct FMatrix4x4
 {
 	union
@@ -175,16 +516,13 @@ struct FMatrix4x4
 
 	FMatrix4x4 GetTranspose() const
 	{
+#if ENABLE_SIMD
 		FMatrix4x4 New;
-		for (int i = 0; i < 4; ++i)
-		{
-			for (int j = 0; j < 4; ++j)
-			{
-				New.Values[i * 4 + j] = Values[j * 4 + i];
-			}
-		}
-
+		TransposeSimd<false>(*this, New);
 		return New;
+#else
+		return GetTransposeScalar();
+#endif
 	}
 
 	static FMatrix4x4 GetZero()
@@ -249,6 +587,542 @@ struct FMatrix4x4
 		Out.w = V.Dot(Rows[3]);
 		return Out;
 	}
+
+	// Out[i] = Transform(In[i]); In and Out may be the same array
+	void Transform(const FVector4* In, uint32 Num, FVector4* Out) const
+	{
+#if ENABLE_SIMD
+		// Transform(V) is a sum of the columns scaled by V's components
+		FMatrix4x4 Columns;
+		TransposeSimd<false>(*this, Columns);
+		const __m128 C0 = _mm_loadu_ps(Columns.Values + 0);
+		const __m128 C1 = _mm_loadu_ps(Columns.Values + 4);
+		const __m128 C2 = _mm_loadu_ps(Columns.Values + 8);
+		const __m128 C3 = _mm_loadu_ps(Columns.Values + 12);
+		for (uint32 Index = 0; Index < Num; ++Index)
+		{
+			const __m128 V = _mm_loadu_ps(In[Index].Values);
+			const __m128 R = _mm_add_ps(_mm_add_ps(_mm_mul_ps(SIMD_SWIZZLE(V, 0, 0, 0, 0), C0), _mm_mul_ps(SIMD_SWIZZLE(V, 1, 1, 1, 1), C1)),
+				_mm_add_ps(_mm_mul_ps(SIMD_SWIZZLE(V, 2, 2, 2, 2), C2), _mm_mul_ps(SIMD_SWIZZLE(V, 3, 3, 3, 3), C3)));
+			_mm_storeu_ps(Out[Index].Values, R);
+		}
+#else
+		for (uint32 Index = 0; Index < Num; ++Index)
+		{
+			Out[Index] = Transform(In[Index]);
+		}
+#endif
+	}
+
+	// this * M; with the shaders' row vectors Pos * A.Mul(B) is Pos * A then * B
+	FMatrix4x4 Mul(const FMatrix4x4& M) const
+	{
+#if ENABLE_SIMD
+		FMatrix4x4 New;
+		MulSimd<false>(*this, M, New);
+		return New;
+#else
+		return MulScalar(M);
+#endif
+	}
+
+	// Only for invertible matrices; a singular one gives infinities/NaNs
+	FMatrix4x4 GetInverse() const
+	{
+#if ENABLE_SIMD
+		FMatrix4x4 New;
+		InverseSimd<false>(*this, New);
+		return New;
+#else
+		return GetInverseScalar();
+#endif
+	}
+
+	// Reference versions, always there so the SIMD paths can be checked against them
+	FMatrix4x4 GetTransposeScalar() const
+	{
+		FMatrix4x4 New;
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				New.Values[i * 4 + j] = Values[j * 4 + i];
+			}
+		}
+
+		return New;
+	}
+
+	FMatrix4x4 MulScalar(const FMatrix4x4& M) const
+	{
+		FMatrix4x4 New;
+		for (int i = 0; i < 4; ++i)
+		{
+			for (int j = 0; j < 4; ++j)
+			{
+				New.Values[i * 4 + j] = Values[i * 4 + 0] * M.Values[0 * 4 + j] + Values[i * 4 + 1] * M.Values[1 * 4 + j] +
+					Values[i * 4 + 2] * M.Values[2 * 4 + j] + Values[i * 4 + 3] * M.Values[3 * 4 + j];
+			}
+		}
+
+		return New;
+	}
+
+	// Adjugate over determinant, with the cofactors from 2x2 minors of the top and bottom row pairs
+	FMatrix4x4 GetInverseScalar() const
+	{
+		const float* m = Values;
+		const float S0 = m[0] * m[5] - m[1] * m[4];
+		const float S1 = m[0] * m[6] - m[2] * m[4];
+		const float S2 = m[0] * m[7] - m[3] * m[4];
+		const float S3 = m[1] * m[6] - m[2] * m[5];
+		const float S4 = m[1] * m[7] - m[3] * m[5];
+		const float S5 = m[2] * m[7] - m[3] * m[6];
+		const float C5 = m[10] * m[15] - m[11] * m[14];
+		const float C4 = m[9] * m[15] - m[11] * m[13];
+		const float C3 = m[9] * m[14] - m[10] * m[13];
+		const float C2 = m[8] * m[15] - m[11] * m[12];
+		const float C1 = m[8] * m[14] - m[10] * m[12];
+		const float C0 = m[8] * m[13] - m[9] * m[12];
+		const float InvDet = 1.0f / (S0 * C5 - S1 * C4 + S2 * C3 + S3 * C2 - S4 * C1 + S5 * C0);
+
+		FMatrix4x4 New;
+		New.Values[0] = (m[5] * C5 - m[6] * C4 + m[7] * C3) * InvDet;
+		New.Values[1] = (-m[1] * C5 + m[2] * C4 - m[3] * C3) * InvDet;
+		New.Values[2] = (m[13] * S5 - m[14] * S4 + m[15] * S3) * InvDet;
+		New.Values[3] = (-m[9] * S5 + m[10] * S4 - m[11] * S3) * InvDet;
+		New.Values[4] = (-m[4] * C5 + m[6] * C2 - m[7] * C1) * InvDet;
+		New.Values[5] = (m[0] * C5 - m[2] * C2 + m[3] * C1) * InvDet;
+		New.Values[6] = (-m[12] * S5 + m[14] * S2 - m[15] * S1) * InvDet;
+		New.Values[7] = (m[8] * S5 - m[10] * S2 + m[11] * S1) * InvDet;
+		New.Values[8] = (m[4] * C4 - m[5] * C2 + m[7] * C0) * InvDet;
+		New.Values[9] = (-m[0] * C4 + m[1] * C2 - m[3] * C0) * InvDet;
+		New.Values[10] = (m[12] * S4 - m[13] * S2 + m[15] * S0) * InvDet;
+		New.Values[11] = (-m[8] * S4 + m[9] * S2 - m[11] * S0) * InvDet;
+		New.Values[12] = (-m[4] * C3 + m[5] * C1 - m[6] * C0) * InvDet;
+		New.Values[13] = (m[0] * C3 - m[1] * C1 + m[2] * C0) * InvDet;
+		New.Values[14] = (-m[12] * S3 + m[13] * S1 - m[14] * S0) * InvDet;
+		New.Values[15] = (m[8] * S3 - m[9] * S1 + m[10] * S0) * InvDet;
+		return New;
+	}
+
+#if ENABLE_SIMD
+	// bAligned uses aligned loads/stores, for FAlignedMatrix4x4
+	template <bool bAligned>
+	static __m128 LoadRow(const FMatrix4x4& M, int32 Row)
+	{
+		return bAligned ? _mm_load_ps(M.Values + Row * 4) : _mm_loadu_ps(M.Values + Row * 4);
+	}
+
+	template <bool bAligned>
+	static void StoreRow(FMatrix4x4& M, int32 Row, __m128 V)
+	{
+		if (bAligned)
+		{
+			_mm_store_ps(M.Values + Row * 4, V);
+		}
+		else
+		{
+			_mm_storeu_ps(M.Values + Row * 4, V);
+		}
+	}
+
+	template <bool bAligned>
+	static void TransposeSimd(const FMatrix4x4& M, FMatrix4x4& Out)
+	{
+		__m128 R0 = LoadRow<bAligned>(M, 0);
+		__m128 R1 = LoadRow<bAligned>(M, 1);
+		__m128 R2 = LoadRow<bAligned>(M, 2);
+		__m128 R3 = LoadRow<bAligned>(M, 3);
+		_MM_TRANSPOSE4_PS(R0, R1, R2, R3);
+		StoreRow<bAligned>(Out, 0, R0);
+		StoreRow<bAligned>(Out, 1, R1);
+		StoreRow<bAligned>(Out, 2, R2);
+		StoreRow<bAligned>(Out, 3, R3);
+	}
+
+	// Each row of the result is A's row dotted into B as a sum of B's rows; Out may alias A or B
+	template <bool bAligned>
+	static void MulSimd(const FMatrix4x4& A, const FMatrix4x4& B, FMatrix4x4& Out)
+	{
+		const __m128 B0 = LoadRow<bAligned>(B, 0);
+		const __m128 B1 = LoadRow<bAligned>(B, 1);
+		const __m128 B2 = LoadRow<bAligned>(B, 2);
+		const __m128 B3 = LoadRow<bAligned>(B, 3);
+		__m128 Rows[4];
+		for (int32 Row = 0; Row < 4; ++Row)
+		{
+			const __m128 R = LoadRow<bAligned>(A, Row);
+			Rows[Row] = _mm_add_ps(_mm_add_ps(_mm_mul_ps(SIMD_SWIZZLE(R, 0, 0, 0, 0), B0), _mm_mul_ps(SIMD_SWIZZLE(R, 1, 1, 1, 1), B1)),
+				_mm_add_ps(_mm_mul_ps(SIMD_SWIZZLE(R, 2, 2, 2, 2), B2), _mm_mul_ps(SIMD_SWIZZLE(R, 3, 3, 3, 3), B3)));
+		}
+		for (int32 Row = 0; Row < 4; ++Row)
+		{
+			StoreRow<bAligned>(Out, Row, Rows[Row]);
+		}
+	}
+
+	// Block inverse on the 2x2 sub matrices A B / C D, each held row major in one register:
+	// inverse = 1/|M| * [|D|A - B(D#C), |B|C - D(A#B)#; |C|B - A(D#C)#, |A|D - C(A#B)]# where # is the adjugate,
+	// |M| = |A||D| + |B||C| - tr((A#B)(D#C))
+	template <bool bAligned>
+	static void InverseSimd(const FMatrix4x4& M, FMatrix4x4& Out)
+	{
+		// 2x2 products: X * Y, X# * Y and X * Y#
+		auto Mul2 = [](__m128 X, __m128 Y)
+		{
+			return _mm_add_ps(_mm_mul_ps(X, SIMD_SWIZZLE(Y, 0, 3, 0, 3)), _mm_mul_ps(SIMD_SWIZZLE(X, 1, 0, 3, 2), SIMD_SWIZZLE(Y, 2, 1, 2, 1)));
+		};
+		auto AdjMul2 = [](__m128 X, __m128 Y)
+		{
+			return _mm_sub_ps(_mm_mul_ps(SIMD_SWIZZLE(X, 3, 3, 0, 0), Y), _mm_mul_ps(SIMD_SWIZZLE(X, 1, 1, 2, 2), SIMD_SWIZZLE(Y, 2, 3, 0, 1)));
+		};
+		auto MulAdj2 = [](__m128 X, __m128 Y)
+		{
+			return _mm_sub_ps(_mm_mul_ps(X, SIMD_SWIZZLE(Y, 3, 0, 3, 0)), _mm_mul_ps(SIMD_SWIZZLE(X, 1, 0, 3, 2), SIMD_SWIZZLE(Y, 2, 1, 2, 1)));
+		};
+
+		const __m128 R0 = LoadRow<bAligned>(M, 0);
+		const __m128 R1 = LoadRow<bAligned>(M, 1);
+		const __m128 R2 = LoadRow<bAligned>(M, 2);
+		const __m128 R3 = LoadRow<bAligned>(M, 3);
+		const __m128 A = _mm_movelh_ps(R0, R1);
+		const __m128 B = _mm_movehl_ps(R1, R0);
+		const __m128 C = _mm_movelh_ps(R2, R3);
+		const __m128 D = _mm_movehl_ps(R3, R2);
+
+		// |A| |B| |C| |D|
+		const __m128 Determinants = _mm_sub_ps(_mm_mul_ps(SIMD_SHUFFLE(R0, R2, 0, 2, 0, 2), SIMD_SHUFFLE(R1, R3, 1, 3, 1, 3)),
+			_mm_mul_ps(SIMD_SHUFFLE(R0, R2, 1, 3, 1, 3), SIMD_SHUFFLE(R1, R3, 0, 2, 0, 2)));
+		const __m128 DetA = SIMD_SWIZZLE(Determinants, 0, 0, 0, 0);
+		const __m128 DetB = SIMD_SWIZZLE(Determinants, 1, 1, 1, 1);
+		const __m128 DetC = SIMD_SWIZZLE(Determinants, 2, 2, 2, 2);
+		const __m128 DetD = SIMD_SWIZZLE(Determinants, 3, 3, 3, 3);
+
+		const __m128 AdjDC = AdjMul2(D, C);
+		const __m128 AdjAB = AdjMul2(A, B);
+		__m128 X = _mm_sub_ps(_mm_mul_ps(DetD, A), Mul2(B, AdjDC));
+		__m128 W = _mm_sub_ps(_mm_mul_ps(DetA, D), Mul2(C, AdjAB));
+		__m128 Y = _mm_sub_ps(_mm_mul_ps(DetB, C), MulAdj2(D, AdjAB));
+		__m128 Z = _mm_sub_ps(_mm_mul_ps(DetC, B), MulAdj2(A, AdjDC));
+
+		__m128 Trace = _mm_mul_ps(AdjAB, SIMD_SWIZZLE(AdjDC, 0, 2, 1, 3));
+		Trace = _mm_add_ps(Trace, SIMD_SWIZZLE(Trace, 2, 3, 0, 1));
+		Trace = _mm_add_ps(Trace, SIMD_SWIZZLE(Trace, 1, 0, 3, 2));
+		const __m128 Det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(DetA, DetD), _mm_mul_ps(DetB, DetC)), Trace);
+
+		// The adjugate's sign pattern folded into the reciprocal
+		const __m128 InvDet = _mm_div_ps(_mm_setr_ps(1, -1, -1, 1), Det);
+		X = _mm_mul_ps(X, InvDet);
+		Y = _mm_mul_ps(Y, InvDet);
+		Z = _mm_mul_ps(Z, InvDet);
+		W = _mm_mul_ps(W, InvDet);
+
+		// Adjugate swizzle and putting the blocks back in rows in one go
+		StoreRow<bAligned>(Out, 0, SIMD_SHUFFLE(X, Y, 3, 1, 3, 1));
+		StoreRow<bAligned>(Out, 1, SIMD_SHUFFLE(X, Y, 2, 0, 2, 0));
+		StoreRow<bAligned>(Out, 2, SIMD_SHUFFLE(Z, W, 3, 1, 3, 1));
+		StoreRow<bAligned>(Out, 3, SIMD_SHUFFLE(Z, W, 2, 0, 2, 0));
+	}
+#endif
+};
+
+// Same as FMatrix4x4 but 16 byte aligned, so the SIMD paths load and store it with aligned instructions; for arrays of
+// matrices updated every frame
+struct alignas(16) FAlignedMatrix4x4 : public FMatrix4x4
+{
+	FAlignedMatrix4x4()
+	{
+	}
+
+	FAlignedMatrix4x4(const FMatrix4x4& M) : FMatrix4x4(M)
+	{
+	}
+
+	FAlignedMatrix4x4 GetTranspose() const
+	{
+		FAlignedMatrix4x4 New;
+#if ENABLE_SIMD
+		TransposeSimd<true>(*this, New);
+#else
+		New = GetTransposeScalar();
+#endif
+		return New;
+	}
+
+	FAlignedMatrix4x4 Mul(const FAlignedMatrix4x4& M) const
+	{
+		FAlignedMatrix4x4 New;
+#if ENABLE_SIMD
+		MulSimd<true>(*this, M, New);
+#else
+		New = MulScalar(M);
+#endif
+		return New;
+	}
+
+	FAlignedMatrix4x4 GetInverse() const
+	{
+		FAlignedMatrix4x4 New;
+#if ENABLE_SIMD
+		InverseSimd<true>(*this, New);
+#else
+		New = GetInverseScalar();
+#endif
+		return New;
+	}
+};
+static_assert(sizeof(FAlignedMatrix4x4) == sizeof(FMatrix4x4), "FAlignedMatrix4x4 must only add alignment");
+
+// Rotation, translation and scale: Pos * ToMatrix() scales, then rotates, then translates. Padded to 48 bytes so the
+// SIMD paths can load the vectors as 16 bytes.
+struct FTransform
+{
+	FQuaternion Rotation;
+	FVector3 Translation;
+	float Padding0;
+	FVector3 Scale;
+	float Padding1;
+
+	static FTransform GetIdentity()
+	{
+		FTransform New;
+		MemZero(New);
+		New.Rotation = FQuaternion::GetIdentity();
+		New.Scale = {{{1, 1, 1}}};
+		return New;
+	}
+
+	// this relative to Parent, ie Pos * Compose(Parent).ToMatrix() is Pos * ToMatrix() * Parent.ToMatrix(). Exact unless
+	// a non uniformly scaled parent has rotated children, which would need shear.
+	FTransform Compose(const FTransform& Parent) const
+	{
+#if ENABLE_SIMD
+		FTransform New;
+		ComposeSimd(*this, Parent, New);
+		return New;
+#else
+		return ComposeScalar(Parent);
+#endif
+	}
+
+	FTransform ComposeScalar(const FTransform& Parent) const
+	{
+		FTransform New;
+		New.Rotation = Parent.Rotation.MulScalar(Rotation);
+		New.Translation = Parent.Rotation.Rotate(Translation.Mul3(Parent.Scale)).Add(Parent.Translation);
+		New.Padding0 = 0;
+		New.Scale = Scale.Mul3(Parent.Scale);
+		New.Padding1 = 0;
+		return New;
+	}
+
+	FMatrix4x4 ToMatrix() const
+	{
+		const FQuaternion& Q = Rotation;
+		const float X2 = Q.x + Q.x;
+		const float Y2 = Q.y + Q.y;
+		const float Z2 = Q.z + Q.z;
+		const float XX = Q.x * X2;
+		const float YY = Q.y * Y2;
+		const float ZZ = Q.z * Z2;
+		const float XY = Q.x * Y2;
+		const float XZ = Q.x * Z2;
+		const float YZ = Q.y * Z2;
+		const float WX = Q.w * X2;
+		const float WY = Q.w * Y2;
+		const float WZ = Q.w * Z2;
+
+		// Rows are the rotated (and scaled) axes
+		FMatrix4x4 New;
+		New.Rows[0] = {(1 - YY - ZZ) * Scale.x, (XY + WZ) * Scale.x, (XZ - WY) * Scale.x, 0};
+		New.Rows[1] = {(XY - WZ) * Scale.y, (1 - XX - ZZ) * Scale.y, (YZ + WX) * Scale.y, 0};
+		New.Rows[2] = {(XZ + WY) * Scale.z, (YZ - WX) * Scale.z, (1 - XX - YY) * Scale.z, 0};
+		New.Rows[3] = {Translation.x, Translation.y, Translation.z, 1};
+		return New;
+	}
+
+#if ENABLE_SIMD
+	static void ComposeSimd(const FTransform& Child, const FTransform& Parent, FTransform& Out)
+	{
+		const __m128 ParentRotation = _mm_loadu_ps(&Parent.Rotation.x);
+		const __m128 ParentScale = _mm_loadu_ps(Parent.Scale.Values);
+		const __m128 Translation = _mm_mul_ps(_mm_loadu_ps(Child.Translation.Values), ParentScale);
+		const __m128 Rotation = FQuaternion::MulSimd(ParentRotation, _mm_loadu_ps(&Child.Rotation.x));
+		const __m128 Scale = _mm_mul_ps(_mm_loadu_ps(Child.Scale.Values), ParentScale);
+
+		// The padding floats ride along in the w lanes
+		_mm_storeu_ps(&Out.Rotation.x, Rotation);
+		_mm_storeu_ps(Out.Translation.Values, _mm_add_ps(FQuaternion::RotateSimd(ParentRotation, Translation), _mm_loadu_ps(Parent.Translation.Values)));
+		_mm_storeu_ps(Out.Scale.Values, Scale);
+	}
+#endif
+};
+static_assert(sizeof(FTransform) == 48, "FTransform is loaded 16 bytes at a time");
+
+// Local to world for a hierarchy flattened parents first: Parents[i] is -1 for roots, otherwise less than i. OutWorlds
+// (which may be null) gets the composed transforms and OutMatrices their ToMatrix().
+inline void UpdateWorldTransforms(const FTransform* Locals, const int32* Parents, uint32 NumNodes, FTransform* OutWorlds, FMatrix4x4* OutMatrices)
+{
+	std::vector<FTransform> Worlds;
+	if (!OutWorlds)
+	{
+		Worlds.resize(NumNodes);
+		OutWorlds = Worlds.data();
+	}
+
+	for (uint32 Index = 0; Index < NumNodes; ++Index)
+	{
+		const int32 Parent = Parents[Index];
+		check(Parent < (int32)Index);
+		OutWorlds[Index] = Parent < 0 ? Locals[Index] : Locals[Index].Compose(OutWorlds[Parent]);
+		OutMatrices[Index] = OutWorlds[Index].ToMatrix();
+	}
+}
+
+// Axis aligned box; GetEmpty() is inverted so the first Add() sets it
+struct FBox
+{
+	FVector3 Min;
+	FVector3 Max;
+
+	static FBox GetEmpty()
+	{
+		FBox New;
+		New.Min = {{{FLT_MAX, FLT_MAX, FLT_MAX}}};
+		New.Max = {{{-FLT_MAX, -FLT_MAX, -FLT_MAX}}};
+		return New;
+	}
+
+	bool IsValid() const
+	{
+		return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z;
+	}
+
+	void Add(const FVector3& P)
+	{
+		Min.x = min(Min.x, P.x);
+		Min.y = min(Min.y, P.y);
+		Min.z = min(Min.z, P.z);
+		Max.x = max(Max.x, P.x);
+		Max.y = max(Max.y, P.y);
+		Max.z = max(Max.z, P.z);
+	}
+
+	FVector3 GetCenter() const
+	{
+		return Min.Add(Max).Mul(0.5f);
+	}
+
+	// Half size
+	FVector3 GetExtent() const
+	{
+		return Max.Sub(Min).Mul(0.5f);
+	}
+
+	// Box around the transformed box (Pos * M like the shaders), from the absolute matrix as in Arvo's "Transforming
+	// Axis-Aligned Bounding Boxes"; only valid for affine M
+	FBox Transform(const FMatrix4x4& M) const
+	{
+		const FVector3 Center = GetCenter();
+		const FVector3 Extent = GetExtent();
+		FBox New;
+		for (int j = 0; j < 3; ++j)
+		{
+			float NewCenter = M.Values[3 * 4 + j];
+			float NewExtent = 0;
+			for (int i = 0; i < 3; ++i)
+			{
+				NewCenter += Center.Values[i] * M.Values[i * 4 + j];
+				NewExtent += Extent.Values[i] * fabs(M.Values[i * 4 + j]);
+			}
+			New.Min.Values[j] = NewCenter - NewExtent;
+			New.Max.Values[j] = NewCenter + NewExtent;
+		}
+		return New;
+	}
+};
+
+struct FSphere
+{
+	FVector3 Center;
+	float Radius;
+};
+
+// Planes point inwards: xyz is the normal, w the distance, so a point is inside if Dot(Normal, P) + w >= 0
+struct FFrustum
+{
+	FVector4 Planes[6];
+
+	// Matrix in the shaders' convention (ClipPos = Pos * Matrix) with D3D's 0..1 depth; any space works
+	// (eg pass Obj * View * Proj to get the planes in object space)
+	static FFrustum FromMatrix(const FMatrix4x4& M)
+	{
+		auto Column = [&](int32 Index)
+		{
+			FVector4 C;
+			C.x = M.Values[0 * 4 + Index];
+			C.y = M.Values[1 * 4 + Index];
+			C.z = M.Values[2 * 4 + Index];
+			C.w = M.Values[3 * 4 + Index];
+			return C;
+		};
+		auto Combine = [](const FVector4& A, const FVector4& B, float Sign)
+		{
+			FVector4 P;
+			P.x = A.x + B.x * Sign;
+			P.y = A.y + B.y * Sign;
+			P.z = A.z + B.z * Sign;
+			P.w = A.w + B.w * Sign;
+			return P;
+		};
+
+		FFrustum New;
+		FVector4 W = Column(3);
+		New.Planes[0] = Combine(W, Column(0), 1);		// Left
+		New.Planes[1] = Combine(W, Column(0), -1);		// Right
+		New.Planes[2] = Combine(W, Column(1), 1);		// Bottom
+		New.Planes[3] = Combine(W, Column(1), -1);		// Top
+		New.Planes[4] = Column(2);						// Near
+		New.Planes[5] = Combine(W, Column(2), -1);		// Far
+		for (auto& Plane : New.Planes)
+		{
+			float Length = sqrt(Plane.x * Plane.x + Plane.y * Plane.y + Plane.z * Plane.z);
+			Plane.x /= Length;
+			Plane.y /= Length;
+			Plane.z /= Length;
+			Plane.w /= Length;
+		}
+		return New;
+	}
+
+	bool IsSphereVisible(const FVector3& Center, float Radius) const
+	{
+		for (auto& Plane : Planes)
+		{
+			if (Plane.x * Center.x + Plane.y * Center.y + Plane.z * Center.z + Plane.w < -Radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Conservative: boxes crossing two planes outside a frustum corner pass
+	bool IsBoxVisible(const FBox& Box) const
+	{
+		const FVector3 Center = Box.GetCenter();
+		const FVector3 Extent = Box.GetExtent();
+		for (auto& Plane : Planes)
+		{
+			const float Radius = Extent.x * fabs(Plane.x) + Extent.y * fabs(Plane.y) + Extent.z * fabs(Plane.z);
+			if (Plane.x * Center.x + Plane.y * Center.y + Plane.z * Center.z + Plane.w < -Radius)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
 };
 
 inline uint32 PackNormalToU32(const FVector3& V)
@@ -260,6 +1134,199 @@ inline uint32 PackNormalToU32(const FVector3& V)
 	return Out;
 };
 
+// Round to nearest even; overflows to infinity and keeps NaNs (Fabian Giesen - "float->half variants")
+inline uint16 FloatToHalf(float F)
+{
+	uint32 Bits;
+	memcpy(&Bits, &F, sizeof(Bits));
+	const uint32 Sign = Bits & 0x80000000;
+	Bits ^= Sign;
+
+	uint32 Half;
+	if (Bits >= (127 + 16) << 23)
+	{
+		// Inf or NaN
+		Half = Bits > (255 << 23) ? 0x7e00 : 0x7c00;
+	}
+	else if (Bits < (127 - 14) << 23)
+	{
+		// Denormal or zero: let the float adder do the shifting and rounding
+		const uint32 MagicBits = ((127 - 15) + (23 - 10) + 1) << 23;
+		float Magic;
+		memcpy(&Magic, &MagicBits, sizeof(Magic));
+		float Shifted;
+		memcpy(&Shifted, &Bits, sizeof(Shifted));
+		Shifted += Magic;
+		memcpy(&Half, &Shifted, sizeof(Half));
+		Half -= MagicBits;
+	}
+	else
+	{
+		const uint32 MantissaOdd = (Bits >> 13) & 1;
+		Bits += ((uint32)(15 - 127) << 23) + 0xfff + MantissaOdd;
+		Half = Bits >> 13;
+	}
+	return (uint16)(Half | (Sign >> 16));
+}
+
+inline float HalfToFloat(uint16 Half)
+{
+	const uint32 ShiftedExponent = 0x7c00 << 13;
+	uint32 Bits = (Half & 0x7fff) << 13;
+	const uint32 Exponent = Bits & ShiftedExponent;
+	Bits += (127 - 15) << 23;
+	float F;
+	if (Exponent == ShiftedExponent)
+	{
+		// Inf or NaN
+		Bits += (128 - 16) << 23;
+		memcpy(&F, &Bits, sizeof(F));
+	}
+	else if (Exponent == 0)
+	{
+		// Denormal
+		Bits += 1 << 23;
+		const uint32 MagicBits = 113 << 23;
+		float Magic;
+		memcpy(&Magic, &MagicBits, sizeof(Magic));
+		memcpy(&F, &Bits, sizeof(F));
+		F -= Magic;
+	}
+	else
+	{
+		memcpy(&F, &Bits, sizeof(F));
+	}
+	return (Half & 0x8000) ? -F : F;
+}
+
+// Projects a unit vector onto the octahedron and unfolds it into the [-1, 1] square
+inline FVector2 EncodeOctahedral(const FVector3& N)
+{
+	const float L1 = fabsf(N.x) + fabsf(N.y) + fabsf(N.z);
+	FVector2 E;
+	E.x = L1 > 0 ? N.x / L1 : 0;
+	E.y = L1 > 0 ? N.y / L1 : 0;
+	if (N.z < 0)
+	{
+		const float X = E.x;
+		E.x = (1.0f - fabsf(E.y)) * (X >= 0 ? 1.0f : -1.0f);
+		E.y = (1.0f - fabsf(X)) * (E.y >= 0 ? 1.0f : -1.0f);
+	}
+	return E;
+}
+
+inline FVector3 DecodeOctahedral(const FVector2& E)
+{
+	FVector3 N = {{{E.x, E.y, 1.0f - fabsf(E.x) - fabsf(E.y)}}};
+	const float T = max(-N.z, 0.0f);
+	N.x += N.x >= 0 ? -T : T;
+	N.y += N.y >= 0 ? -T : T;
+	return N.GetNormalized();
+}
+
+// Same mapping as DXGI's _SNORM formats
+inline int8 FloatToSnorm8(float F)
+{
+	F = min(max(F, -1.0f), 1.0f);
+	return (int8)(F * 127.0f + (F >= 0 ? 0.5f : -0.5f));
+}
+
+inline float Snorm8ToFloat(int8 I)
+{
+	return max(I / 127.0f, -1.0f);
+}
+
+inline int16 FloatToSnorm16(float F)
+{
+	F = min(max(F, -1.0f), 1.0f);
+	return (int16)(F * 32767.0f + (F >= 0 ? 0.5f : -0.5f));
+}
+
+inline float Snorm16ToFloat(int16 I)
+{
+	return max(I / 32767.0f, -1.0f);
+}
+
+// Octahedral normal as two snorm16 (x in the low half), ie R16G16_SNORM; about 0.004 degrees of error
+inline uint32 EncodeOctahedral16(const FVector3& N)
+{
+	const FVector2 E = EncodeOctahedral(N);
+	return (uint16)FloatToSnorm16(E.x) | ((uint32)(uint16)FloatToSnorm16(E.y) << 16);
+}
+
+inline FVector3 DecodeOctahedral16(uint32 Packed)
+{
+	FVector2 E;
+	E.x = Snorm16ToFloat((int16)(Packed & 0xffff));
+	E.y = Snorm16ToFloat((int16)(Packed >> 16));
+	return DecodeOctahedral(E);
+}
+
+// Octahedral normal as two snorm8 (x in the low byte), ie R8G8_SNORM; under a degree of error
+inline uint16 EncodeOctahedral8(const FVector3& N)
+{
+	const FVector2 E = EncodeOctahedral(N);
+	return (uint8)FloatToSnorm8(E.x) | ((uint16)(uint8)FloatToSnorm8(E.y) << 8);
+}
+
+inline FVector3 DecodeOctahedral8(uint16 Packed)
+{
+	FVector2 E;
+	E.x = Snorm8ToFloat((int8)(Packed & 0xff));
+	E.y = Snorm8ToFloat((int8)(Packed >> 8));
+	return DecodeOctahedral(E);
+}
+
+// Normal, tangent and bitangent sign (Tangent.w, B = cross(N, T) * w) as a quaternion in 4 snorm8 (x in the low byte),
+// ie R8G8B8A8_SNORM. The bitangent sign is the sign of w, which is kept at least one step away from 0.
+inline uint32 EncodeTangentFrame(const FVector3& Normal, const FVector4& Tangent)
+{
+	const FVector3 T = {{{Tangent.x, Tangent.y, Tangent.z}}};
+	const FVector3 B = Normal.Cross(T);
+	FQuaternion Q = B.Length() > 0.5f ? FQuaternion::FromAxes(T, B, Normal).GetNormalized() : FQuaternion::GetIdentity();
+
+	// Q and -Q are the same rotation
+	if (Q.w < 0)
+	{
+		Q.x = -Q.x;
+		Q.y = -Q.y;
+		Q.z = -Q.z;
+		Q.w = -Q.w;
+	}
+
+	const float MinW = 1.0f / 127.0f;
+	if (Q.w < MinW)
+	{
+		const float Scale = sqrt((1.0f - MinW * MinW) / max(Q.x * Q.x + Q.y * Q.y + Q.z * Q.z, 1e-20f));
+		Q.x *= Scale;
+		Q.y *= Scale;
+		Q.z *= Scale;
+		Q.w = MinW;
+	}
+
+	const float Sign = Tangent.w < 0 ? -1.0f : 1.0f;
+	return (uint8)FloatToSnorm8(Q.x * Sign) | ((uint32)(uint8)FloatToSnorm8(Q.y * Sign) << 8) |
+		((uint32)(uint8)FloatToSnorm8(Q.z * Sign) << 16) | ((uint32)(uint8)FloatToSnorm8(Q.w * Sign) << 24);
+}
+
+inline void DecodeTangentFrame(uint32 Packed, FVector3& OutNormal, FVector4& OutTangent)
+{
+	FQuaternion Q;
+	Q.x = Snorm8ToFloat((int8)(Packed & 0xff));
+	Q.y = Snorm8ToFloat((int8)((Packed >> 8) & 0xff));
+	Q.z = Snorm8ToFloat((int8)((Packed >> 16) & 0xff));
+	Q.w = Snorm8ToFloat((int8)(Packed >> 24));
+	Q = Q.GetNormalized();
+	const FVector3 X = {{{1, 0, 0}}};
+	const FVector3 Z = {{{0, 0, 1}}};
+	OutNormal = Q.Rotate(Z);
+	const FVector3 T = Q.Rotate(X);
+	OutTangent.x = T.x;
+	OutTangent.y = T.y;
+	OutTangent.z = T.z;
+	OutTangent.w = Q.w < 0 ? -1.0f : 1.0f;
+}
+
 inline FMatrix4x4 CalculateProjectionMatrix(float FOVRadians, float Aspect, float NearZ, float FarZ)
 {
 	const float HalfTanFOV = (float)tan(FOVRadians / 2.0);
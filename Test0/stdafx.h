@@ -21,4 +21,7 @@
 // TODO: reference additional headers your program requires here
 #define ENABLE_VULKAN	0
 
+// SSE2 batch paths (always there on x64); 0 runs the scalar reference code instead
+#define ENABLE_SIMD		1
+
 #include <d3d12.h>
\ No newline at end of file
@@ -0,0 +1,406 @@
+// Tests and benchmarks for Test0/Allocators.h. Doesn't need Windows or D3D12:
+//	g++ -O2 -std=c++14 -o AllocatorsTest AllocatorsTest.cpp && ./AllocatorsTest
+// or cl /O2 /EHsc AllocatorsTest.cpp. Prints one line per test and exits with 1 at the first failed verify().
+
+#include "../Test0/Allocators.h"
+#include <stdlib.h>
+#include <algorithm>
+#include <deque>
+#include <chrono>
+
+// Unlike check(), says what failed and leaves a useful exit code for scripts
+#define verify(x) if (!(x)) { printf("%s(%d): failed: %s\n", __FILE__, __LINE__, #x); exit(1); }
+
+static double GetTimeInMs()
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// One allocation as big as the whole allocator has to fit, whatever the size; sizes that aren't on a size class boundary
+// used to round up past the only free block
+static void TestTLSFExactFit()
+{
+	const uint64 Sizes[] = {1, 31, 32, 33, 4096, 65536 + 4096, 16 * 1024 * 1024, 17 * 1024 * 1024 + 4096, 64 * 1024 * 1024 - 256, 3ull * 1024 * 1024 * 1024 + 12345};
+	for (uint64 Size : Sizes)
+	{
+		FTLSFAllocator Allocator;
+		Allocator.Create(Size);
+		uint64 Offset = ~0ull;
+		verify(Allocator.Alloc(Size + 1, 1, Offset) == FTLSFAllocator::INVALID_BLOCK);
+		uint32 Block = Allocator.Alloc(Size, Size % 4096 ? 1 : 4096, Offset);
+		verify(Block != FTLSFAllocator::INVALID_BLOCK && Offset == 0 && Allocator.GetUsed() == Size);
+		verify(Allocator.Alloc(1, 1, Offset) == FTLSFAllocator::INVALID_BLOCK);
+		Allocator.Free(Block);
+		verify(Allocator.IsEmpty() && Allocator.GetStats().NumFreeBlocks == 1);
+
+		// Again after splitting the page in two and merging it back
+		if (Size >= 2)
+		{
+			uint64 FirstOffset, SecondOffset;
+			const uint32 First = Allocator.Alloc(Size / 2, 1, FirstOffset);
+			const uint32 Second = Allocator.Alloc(Size - Size / 2, 1, SecondOffset);
+			verify(First != FTLSFAllocator::INVALID_BLOCK && Second != FTLSFAllocator::INVALID_BLOCK);
+			verify(Allocator.GetUsed() == Size && Allocator.GetStats().FreeBytes == 0);
+			Allocator.Free(Second);
+			Allocator.Free(First);
+			Block = Allocator.Alloc(Size, 1, Offset);
+			verify(Block != FTLSFAllocator::INVALID_BLOCK && Offset == 0);
+			Allocator.Free(Block);
+		}
+	}
+	printf("TLSF exact fit, %u sizes: ok\n", (uint32)(sizeof(Sizes) / sizeof(Sizes[0])));
+}
+
+// Random sizes and alignments in one FTLSFAllocator kept around Fill full, freeing random allocations to make room;
+// checks live allocations are aligned and never overlap, and how fragmented the free space ends up
+static void TestTLSF(uint64 Size, float Fill, uint32 NumOperations)
+{
+	struct FLive
+	{
+		uint32 Block;
+		uint64 Offset;
+		uint64 Size;
+		uint64 Alignment;
+	};
+
+	FTLSFAllocator Allocator;
+	Allocator.Create(Size);
+	std::vector<FLive> Live;
+	uint32 NumFailed = 0;
+	float MaxFragmentation = 0;
+	double StartTime = GetTimeInMs();
+	for (uint32 Index = 0; Index < NumOperations; ++Index)
+	{
+		while (!Live.empty() && Allocator.GetUsed() > (uint64)(Fill * Size))
+		{
+			const uint32 LiveIndex = rand() % (uint32)Live.size();
+			Allocator.Free(Live[LiveIndex].Block);
+			Live[LiveIndex] = Live.back();
+			Live.pop_back();
+		}
+
+		// Sizes spread over 256 bytes to 1 MB, alignments from 256 bytes to 64 KB; like placed resources, sizes are
+		// rounded up to the alignment
+		FLive New;
+		New.Alignment = (uint64)256 << (rand() % 9);
+		New.Size = Align((uint64)256 * (1 + rand() % (1 << (rand() % 12))), New.Alignment);
+		New.Block = Allocator.Alloc(New.Size, New.Alignment, New.Offset);
+		if (New.Block == FTLSFAllocator::INVALID_BLOCK)
+		{
+			// Out of room for this one; free something so the big ones get a chance later
+			++NumFailed;
+			if (!Live.empty())
+			{
+				const uint32 LiveIndex = rand() % (uint32)Live.size();
+				Allocator.Free(Live[LiveIndex].Block);
+				Live[LiveIndex] = Live.back();
+				Live.pop_back();
+			}
+			continue;
+		}
+		Live.push_back(New);
+
+		if ((Index & 4095) == 0)
+		{
+			MaxFragmentation = std::max(MaxFragmentation, Allocator.GetStats().GetFragmentation());
+		}
+	}
+	const double Time = GetTimeInMs() - StartTime;
+
+	std::sort(Live.begin(), Live.end(), [](const FLive& A, const FLive& B)
+		{
+			return A.Offset < B.Offset;
+		});
+	for (uint32 Index = 0; Index < (uint32)Live.size(); ++Index)
+	{
+		verify(Live[Index].Offset % Live[Index].Alignment == 0 && Live[Index].Offset + Live[Index].Size <= Size);
+		verify(Index == 0 || Live[Index - 1].Offset + Live[Index - 1].Size <= Live[Index].Offset);
+	}
+	const FTLSFStats Stats = Allocator.GetStats();
+	verify(Stats.UsedBytes + Stats.FreeBytes == Size && Stats.NumAllocations == (uint32)Live.size());
+
+	// Everything merges back into one block
+	for (const FLive& Allocation : Live)
+	{
+		Allocator.Free(Allocation.Block);
+	}
+	verify(Allocator.IsEmpty() && Allocator.GetStats().LargestFreeBlock == Size);
+
+	printf("TLSF, %.0f MB at %.0f%%, %u allocs: %.1f ns per alloc+free, %u failed, %u free blocks, fragmentation %.2f now %.2f worst\n",
+		Size / (1024.0 * 1024.0), Fill * 100.0f, NumOperations, Time * 1000000.0 / NumOperations, NumFailed, Stats.NumFreeBlocks, Stats.GetFragmentation(), MaxFragmentation);
+}
+
+// Random placed resource sized allocations and frees through FHeapSuballocator, checking that live suballocations never
+// overlap and stay inside their page, and that every page is one free range again once everything is freed
+static void TestHeapSuballocator(uint64 PageSize, uint32 NumLive, uint32 NumOperations)
+{
+	FHeapSuballocator Suballocator;
+	Suballocator.Create(PageSize);
+
+	// Mostly small buffers and textures, a few big ones
+	auto RandomAllocation = [&](uint32& OutPool, uint64& OutSize, uint64& OutAlignment)
+	{
+		OutPool = (uint32)(rand() % 3);
+		const uint32 SizeClass = rand() % 16;
+		const uint64 Size = SizeClass < 12 ? (uint64)(1 + rand() % 64) * 4096 : SizeClass < 15 ? (uint64)(1 + rand() % 64) * 65536 : (uint64)(1 + rand() % 8) * 1024 * 1024;
+		OutAlignment = (OutPool == 1 && Size <= 64 * 1024) ? 4096 : 65536;
+		OutSize = Align(Size, OutAlignment);
+	};
+
+	std::vector<FHeapSuballocation> Live;
+	Live.reserve(NumLive);
+	uint32 NumNewPages = 0;
+	double StartTime = GetTimeInMs();
+	for (uint32 Index = 0; Index < NumLive; ++Index)
+	{
+		uint32 Pool;
+		uint64 Size, Alignment;
+		RandomAllocation(Pool, Size, Alignment);
+		bool bNewPage;
+		Live.push_back(Suballocator.Alloc(Pool, Size, Alignment, bNewPage));
+		NumNewPages += bNewPage ? 1 : 0;
+	}
+	for (uint32 Index = 0; Index < NumOperations; ++Index)
+	{
+		uint32 LiveIndex = rand() % NumLive;
+		Suballocator.Free(Live[LiveIndex]);
+
+		uint32 Pool;
+		uint64 Size, Alignment;
+		RandomAllocation(Pool, Size, Alignment);
+		bool bNewPage;
+		Live[LiveIndex] = Suballocator.Alloc(Pool, Size, Alignment, bNewPage);
+		NumNewPages += bNewPage ? 1 : 0;
+	}
+	const double Time = GetTimeInMs() - StartTime;
+	verify(NumNewPages == Suballocator.GetNumPages());
+
+	std::vector<FHeapSuballocation> Sorted = Live;
+	std::sort(Sorted.begin(), Sorted.end(), [](const FHeapSuballocation& A, const FHeapSuballocation& B)
+		{
+			return A.Page != B.Page ? A.Page < B.Page : A.Offset < B.Offset;
+		});
+	uint64 UsedBytes = 0;
+	for (uint32 Index = 0; Index < (uint32)Sorted.size(); ++Index)
+	{
+		const FHeapSuballocation& Suballocation = Sorted[Index];
+		verify(Suballocation.IsValid());
+		verify(Suballocation.Offset + Suballocation.Size <= Suballocator.GetPageSize());
+		verify(Index == 0 || Sorted[Index - 1].Page != Suballocation.Page || Sorted[Index - 1].Offset + Sorted[Index - 1].Size <= Suballocation.Offset);
+		UsedBytes += Suballocation.Size;
+	}
+	uint32 MaxFreeBlocks = 0;
+	float MaxFragmentation = 0;
+	for (uint32 Page = 0; Page < Suballocator.GetNumPages(); ++Page)
+	{
+		const FTLSFStats Stats = Suballocator.GetPageRanges(Page).GetStats();
+		verify(Stats.UsedBytes + Stats.FreeBytes == PageSize);
+		MaxFreeBlocks = std::max(MaxFreeBlocks, Stats.NumFreeBlocks);
+		MaxFragmentation = std::max(MaxFragmentation, Stats.GetFragmentation());
+	}
+
+	for (const FHeapSuballocation& Suballocation : Live)
+	{
+		Suballocator.Free(Suballocation);
+	}
+	for (uint32 Page = 0; Page < Suballocator.GetNumPages(); ++Page)
+	{
+		verify(Suballocator.GetPageRanges(Page).IsEmpty());
+		verify(Suballocator.GetPageRanges(Page).GetStats().LargestFreeBlock == PageSize);
+	}
+	Suballocator.Destroy();
+
+	printf("Heap suballocator, %u live, %u free+alloc: %.1f ns per operation, %u pages for %.1f MB live (%.1f%% used), up to %u free blocks and %.2f fragmentation per page\n",
+		NumLive, NumOperations, Time * 1000000.0 / (NumLive + 2.0 * NumOperations), NumNewPages, UsedBytes / (1024.0 * 1024.0),
+		100.0 * UsedBytes / ((double)NumNewPages * Suballocator.GetPageSize()), MaxFreeBlocks, MaxFragmentation);
+}
+
+// FRingAllocator with a simulated GPU running up to 3 frames behind. Every allocation is filled with its frame number,
+// and when the fake fence for a frame completes all of that frame's allocations must still hold it.
+static void TestUploadRing(uint64 Size, uint32 NumFrames)
+{
+	struct FAllocation
+	{
+		uint64 Offset;
+		uint64 Size;
+	};
+
+	FRingAllocator Ring;
+	Ring.Create(Size);
+	std::vector<uint32> Memory((size_t)(Size / sizeof(uint32)));
+	std::deque<std::vector<FAllocation>> InFlight;
+	uint64 CompletedFence = 0;
+	uint64 NumAllocations = 0;
+	uint32 NumStalls = 0;
+	uint32 NumErrors = 0;
+
+	// Runs the oldest frame on the "GPU": checks its data and signals its fence
+	auto CompleteFrame = [&]()
+	{
+		++CompletedFence;
+		for (const FAllocation& Allocation : InFlight.front())
+		{
+			for (uint64 Index = Allocation.Offset / sizeof(uint32); Index < (Allocation.Offset + Allocation.Size) / sizeof(uint32); ++Index)
+			{
+				NumErrors += Memory[(size_t)Index] != (uint32)CompletedFence ? 1 : 0;
+			}
+		}
+		InFlight.pop_front();
+		Ring.Retire(CompletedFence);
+	};
+
+	double StartTime = GetTimeInMs();
+	for (uint32 Frame = 1; Frame <= NumFrames; ++Frame)
+	{
+		// A few hundred draws, each with one or two constant buffers
+		InFlight.emplace_back();
+		const uint32 NumDraws = 100 + rand() % 400;
+		for (uint32 Draw = 0; Draw < NumDraws; ++Draw)
+		{
+			FAllocation Allocation;
+			Allocation.Size = 256 * (1 + rand() % 2);
+			while (!Ring.Alloc(Allocation.Size, 256, Allocation.Offset))
+			{
+				// Like FUploadRing::Alloc() waiting on the fence
+				verify(!InFlight.empty());
+				++NumStalls;
+				CompleteFrame();
+			}
+			verify(Allocation.Offset % 256 == 0 && Allocation.Offset + Allocation.Size <= Size);
+			for (uint64 Index = Allocation.Offset / sizeof(uint32); Index < (Allocation.Offset + Allocation.Size) / sizeof(uint32); ++Index)
+			{
+				Memory[(size_t)Index] = Frame;
+			}
+			InFlight.back().push_back(Allocation);
+			++NumAllocations;
+		}
+		Ring.EndFrame(Frame);
+
+		// The GPU finishes 0 to 3 frames in the meantime, never running more than 3 behind
+		for (uint32 Complete = rand() % 4; Complete > 0 && !InFlight.empty(); --Complete)
+		{
+			CompleteFrame();
+		}
+		while (InFlight.size() > 3)
+		{
+			CompleteFrame();
+		}
+	}
+	while (!InFlight.empty())
+	{
+		CompleteFrame();
+	}
+	const double Time = GetTimeInMs() - StartTime;
+	verify(NumErrors == 0 && Ring.GetNumFramesInFlight() == 0 && Ring.GetUsed() == 0);
+
+	printf("Upload ring, %.0f KB, %u frames: %llu allocations, %u stalls on the fence, %u overwritten values, %.1f ms\n",
+		Size / 1024.0, NumFrames, (unsigned long long)NumAllocations, NumStalls, NumErrors, Time);
+}
+
+
+// Resources are created and released every frame while a simulated GPU runs 0-3 frames behind; checks nothing is
+// reused or destroyed before the GPU is done with it
+static void TestRecycler(uint32 NumFrames, uint32 MaxPoolAge)
+{
+	struct FItem
+	{
+		uint32 Key;
+		uint64 LastUsedFence;
+	};
+
+	FRecycler<uint32, FItem*> Recycler;
+	std::vector<FItem*> Live;
+	uint64 CompletedFence = 0;
+	uint64 NumAcquired = 0;
+	uint64 NumCreated = 0;
+	uint64 NumDestroyed = 0;
+	uint32 MaxPooled = 0;
+	uint32 NumErrors = 0;
+
+	auto Destroy = [&](FItem* Item)
+	{
+		NumErrors += Item->LastUsedFence > CompletedFence ? 1 : 0;
+		++NumDestroyed;
+		delete Item;
+	};
+
+	double StartTime = GetTimeInMs();
+	for (uint32 Frame = 1; Frame <= NumFrames; ++Frame)
+	{
+		// Like FMemManager::AllocBuffer(): a handful of sizes, reused when possible
+		const uint32 NumNew = rand() % 8;
+		for (uint32 Index = 0; Index < NumNew; ++Index)
+		{
+			const uint32 Key = rand() % 16;
+			FItem* Item = nullptr;
+			if (Recycler.Acquire(Key, Item))
+			{
+				NumErrors += Item->LastUsedFence > CompletedFence ? 1 : 0;
+				++NumAcquired;
+			}
+			else
+			{
+				Item = new FItem;
+				Item->Key = Key;
+				++NumCreated;
+			}
+			Live.push_back(Item);
+		}
+
+		// Everything alive is used by this frame's command lists, then some are released with the fence value signaled at the
+		// end of this frame, like FMemManager::Release()
+		for (FItem* Item : Live)
+		{
+			Item->LastUsedFence = Frame;
+		}
+		for (uint32 Index = 0; Index < Live.size();)
+		{
+			if (rand() % 4 == 0)
+			{
+				Recycler.Release(Live[Index]->Key, Live[Index], Frame);
+				Live[Index] = Live.back();
+				Live.pop_back();
+			}
+			else
+			{
+				++Index;
+			}
+		}
+
+		// Like FMemManager::EndFrame(): signal this frame, the GPU catches up to 0-3 frames behind
+		const uint32 Lag = std::min(Frame, (uint32)(rand() % 4));
+		CompletedFence = std::max(CompletedFence, (uint64)(Frame - Lag));
+		Recycler.Process(CompletedFence, MaxPoolAge, Destroy);
+		MaxPooled = std::max(MaxPooled, Recycler.GetNumPooled());
+	}
+	const double Time = GetTimeInMs() - StartTime;
+
+	// Release the rest and let an idle GPU catch up past them so the pool empties
+	for (FItem* Item : Live)
+	{
+		Recycler.Release(Item->Key, Item, NumFrames);
+	}
+	Live.clear();
+	CompletedFence = NumFrames + 1;
+	Recycler.Process(CompletedFence, 0, Destroy);
+	verify(NumErrors == 0 && NumDestroyed == NumCreated && Recycler.GetNumPending() == 0 && Recycler.GetNumPooled() == 0);
+	verify(MaxPoolAge == 0 || NumAcquired > NumCreated);
+
+	printf("Recycler, age %u, %u frames: %llu created, %llu reused, at most %u pooled, %u used too early, %.1f ns per allocation\n",
+		MaxPoolAge, NumFrames, (unsigned long long)NumCreated, (unsigned long long)NumAcquired, MaxPooled, NumErrors, Time * 1000000.0 / (double)(NumCreated + NumAcquired));
+}
+
+int main()
+{
+	srand(1);
+	TestTLSFExactFit();
+	TestTLSF(256 * 1024 * 1024, 0.8f, 1000000);
+	TestHeapSuballocator(64 * 1024 * 1024, 2000, 200000);
+	TestUploadRing(256 * 1024, 20000);
+
+	// FMemManager's MAX_RECYCLE_AGE, then destroying everything as soon as the GPU is done with it
+	TestRecycler(100000, 60);
+	TestRecycler(100000, 0);
+	printf("All allocator tests passed\n");
+	return 0;
+}
@@ -0,0 +1,679 @@
+// Tests and benchmarks for Test0/Mesh.h, Util.h and ObjLoader.h. They build with the app's stdafx.h, so they need
+// the Windows SDK headers, but no device:
+//	cl /O2 /EHsc /I../Test0 MeshTest.cpp ../Test0/Mesh.cpp ../Test0/ObjLoader.cpp psapi.lib && MeshTest [file.obj]
+// Prints one line per test and exits with 1 at the first failed verify(). Given an .obj, also times loading it every
+// way and checks they all agree.
+
+#include "stdafx.h"
+#include "Util.h"
+#include "Mesh.h"
+#include "ObjLoader.h"
+#include <string>
+
+// Unlike check(), says what failed and leaves a useful exit code for scripts
+#define verify(x) if (!(x)) { printf("%s(%d): failed: %s\n", __FILE__, __LINE__, #x); exit(1); }
+
+// Where the app's camera starts; culling tests look from here
+static const FVector4 GCameraPos = {0, 0, 10, 1};
+
+// Shared by the tests below
+static float GetRandomFloat(float Min, float Max)
+{
+	return Min + (Max - Min) * (float)rand() / (float)RAND_MAX;
+}
+
+// Average ms per call of Lambda(Iteration) over NumIterations calls
+template <typename TLambda>
+static double TimeInMs(uint32 NumIterations, TLambda Lambda)
+{
+	double StartTime = GetTimeInMs();
+	for (uint32 Iteration = 0; Iteration < NumIterations; ++Iteration)
+	{
+		Lambda(Iteration);
+	}
+	return (GetTimeInMs() - StartTime) / NumIterations;
+}
+
+// Times culling NumBoxes random boxes against the starting view, a frame's worth of work per iteration
+static void TestCulling(uint32 NumBoxes, uint32 NumFrames, float Aspect)
+{
+	FCullBounds Bounds;
+	Bounds.Reserve(NumBoxes);
+	std::vector<FBox> Boxes(NumBoxes);
+	for (auto& Box : Boxes)
+	{
+		const float Size = GetRandomFloat(0.5f, 5.0f);
+		Box.Min = {{{GetRandomFloat(-500, 500), GetRandomFloat(-500, 500), GetRandomFloat(-500, 500)}}};
+		Box.Max = Box.Min.Add({{{Size, Size, Size}}});
+		Bounds.Add(Box);
+	}
+
+	FMatrix4x4 View = FMatrix4x4::GetIdentity();
+	View.Rows[3] = GCameraPos;
+	const FMatrix4x4 Proj = CalculateProjectionMatrix(ToRadians(60), Aspect, 0.1f, 1000.0f);
+	const FFrustum Frustum = FFrustum::FromMatrix(View.Mul(Proj));
+
+	std::vector<uint32> Visible;
+	const double BoxesTime = TimeInMs(NumFrames, [&](uint32) { CullBoxes(Frustum, Bounds, Visible); });
+	const uint32 NumVisibleBoxes = (uint32)Visible.size();
+
+	const double SpheresTime = TimeInMs(NumFrames, [&](uint32) { CullSpheres(Frustum, Bounds, Visible); });
+	const uint32 NumVisibleSpheres = (uint32)Visible.size();
+
+	// What per draw tests would cost
+	uint32 NumVisibleScalar = 0;
+	const double ScalarTime = TimeInMs(NumFrames, [&](uint32)
+		{
+			NumVisibleScalar = 0;
+			for (auto& Box : Boxes)
+			{
+				NumVisibleScalar += Frustum.IsBoxVisible(Box) ? 1 : 0;
+			}
+		});
+
+	printf("Culling %u boxes: %.3f ms as boxes (%u visible), %.3f ms as spheres (%u visible), %.3f ms one FBox at a time (%u visible)\n",
+		NumBoxes, BoxesTime, NumVisibleBoxes, SpheresTime, NumVisibleSpheres, ScalarTime, NumVisibleScalar);
+
+	// Same planes as FFrustum::IsBoxVisible(), and a box's bounding sphere can only be visible more often
+	verify(NumVisibleBoxes == NumVisibleScalar && NumVisibleSpheres >= NumVisibleBoxes);
+}
+
+// Checks the FMatrix4x4 SIMD paths match the scalar references on random well conditioned matrices and times both
+static void TestMatrixMath(uint32 NumIterations)
+{
+	const uint32 NumMatrices = 1024;
+	std::vector<FMatrix4x4> Matrices(NumMatrices);
+	std::vector<FVector4> Points(4096);
+	for (auto& M : Matrices)
+	{
+		for (float& Value : M.Values)
+		{
+			Value = GetRandomFloat(-1, 1);
+		}
+		for (uint32 Index = 0; Index < 4; ++Index)
+		{
+			M.Values[Index * 5] += 4;
+		}
+	}
+	for (auto& Point : Points)
+	{
+		Point = {GetRandomFloat(-1, 1), GetRandomFloat(-1, 1), GetRandomFloat(-1, 1), 1};
+	}
+
+	auto GetError = [](const FMatrix4x4& A, const FMatrix4x4& B)
+	{
+		float Error = 0;
+		for (uint32 Index = 0; Index < 16; ++Index)
+		{
+			Error = max(Error, fabs(A.Values[Index] - B.Values[Index]));
+		}
+		return Error;
+	};
+	float MulError = 0;
+	float InverseError = 0;
+	float TransposeError = 0;
+	float TransformError = 0;
+	std::vector<FVector4> Transformed(Points.size());
+	for (uint32 Index = 0; Index < NumMatrices; ++Index)
+	{
+		const FMatrix4x4& A = Matrices[Index];
+		const FMatrix4x4& B = Matrices[NumMatrices - 1 - Index];
+		MulError = max(MulError, GetError(A.Mul(B), A.MulScalar(B)));
+		InverseError = max(InverseError, GetError(A.GetInverse(), A.GetInverseScalar()));
+		TransposeError = max(TransposeError, GetError(A.GetTranspose(), A.GetTransposeScalar()));
+		A.Transform(Points.data(), 16, Transformed.data());
+		for (uint32 PointIndex = 0; PointIndex < 16; ++PointIndex)
+		{
+			const FVector4 Expected = A.Transform(Points[PointIndex]);
+			for (uint32 Component = 0; Component < 4; ++Component)
+			{
+				TransformError = max(TransformError, fabs(Expected.Values[Component] - Transformed[PointIndex].Values[Component]));
+			}
+		}
+	}
+
+	// Only rounding can differ: entries are under 5 and products under about 50, so a wrong term would be off by far more
+	verify(MulError < 1e-4f && InverseError < 1e-5f && TransposeError == 0 && TransformError < 1e-5f);
+
+	// Results go through Sink so the loops aren't optimized away
+	std::vector<FMatrix4x4> Out(NumMatrices);
+	float Sink = 0;
+	auto Time = [&](auto Lambda)
+	{
+		return TimeInMs(NumIterations, [&](uint32 Iteration)
+			{
+				for (uint32 Index = 0; Index < NumMatrices; ++Index)
+				{
+					Out[Index] = Lambda(Matrices[Index], Matrices[NumMatrices - 1 - Index]);
+				}
+				Sink += Out[Iteration % NumMatrices].Values[Iteration % 16];
+			}) * 1000000.0 / NumMatrices;
+	};
+	const double MulScalarTime = Time([](const FMatrix4x4& A, const FMatrix4x4& B) { return A.MulScalar(B); });
+	const double MulTime = Time([](const FMatrix4x4& A, const FMatrix4x4& B) { return A.Mul(B); });
+	const double InverseScalarTime = Time([](const FMatrix4x4& A, const FMatrix4x4&) { return A.GetInverseScalar(); });
+	const double InverseTime = Time([](const FMatrix4x4& A, const FMatrix4x4&) { return A.GetInverse(); });
+	const double TransposeScalarTime = Time([](const FMatrix4x4& A, const FMatrix4x4&) { return A.GetTransposeScalar(); });
+	const double TransposeTime = Time([](const FMatrix4x4& A, const FMatrix4x4&) { return A.GetTranspose(); });
+
+	const double TransformOneTime = TimeInMs(NumIterations, [&](uint32 Iteration)
+		{
+			const FMatrix4x4& M = Matrices[Iteration % NumMatrices];
+			for (uint32 Index = 0; Index < (uint32)Points.size(); ++Index)
+			{
+				Transformed[Index] = M.Transform(Points[Index]);
+			}
+			Sink += Transformed[Iteration % Points.size()].x;
+		}) * 1000000.0 / Points.size();
+	const double TransformArrayTime = TimeInMs(NumIterations, [&](uint32 Iteration)
+		{
+			Matrices[Iteration % NumMatrices].Transform(Points.data(), (uint32)Points.size(), Transformed.data());
+			Sink += Transformed[Iteration % Points.size()].x;
+		}) * 1000000.0 / Points.size();
+
+	printf("Matrix math (ns each, scalar -> SIMD): mul %.2f -> %.2f, inverse %.2f -> %.2f, transpose %.2f -> %.2f, transform %.2f -> %.2f; "
+		"max differences mul %g, inverse %g, transpose %g, transform %g; checksum %g\n",
+		MulScalarTime, MulTime, InverseScalarTime, InverseTime, TransposeScalarTime, TransposeTime, TransformOneTime, TransformArrayTime,
+		MulError, InverseError, TransposeError, TransformError, Sink);
+}
+
+// Pre-transforming NumPositions vertex positions and their bounds one FMatrix4x4::Transform() at a time versus
+// TransformPositions() on interleaved vertices, x/y/z streams and all cores
+static void TestTransforms(uint32 NumPositions, uint32 NumIterations)
+{
+	std::vector<FMeshVertex> Vertices(NumPositions);
+	std::vector<FMeshVertex> Transformed(NumPositions);
+	std::vector<float> X(NumPositions), Y(NumPositions), Z(NumPositions);
+	std::vector<float> OutX(NumPositions), OutY(NumPositions), OutZ(NumPositions);
+	for (uint32 Index = 0; Index < NumPositions; ++Index)
+	{
+		FMeshVertex& Vertex = Vertices[Index];
+		MemZero(Vertex);
+		Vertex.Pos = {{{GetRandomFloat(0, 1), GetRandomFloat(0, 1), GetRandomFloat(0, 1)}}};
+		X[Index] = Vertex.Pos.x;
+		Y[Index] = Vertex.Pos.y;
+		Z[Index] = Vertex.Pos.z;
+	}
+	FMatrix4x4 M = FMatrix4x4::GetRotationY(0.3f).Mul(FMatrix4x4::GetRotationZ(0.2f));
+	M.Rows[3] = {5, -3, 2, 1};
+
+	// Transform() is M * V, so it needs the transpose to match the shaders
+	const FMatrix4x4 Transpose = M.GetTranspose();
+	FBox Bounds;
+	const double OneTime = TimeInMs(NumIterations, [&](uint32)
+		{
+			Bounds = FBox::GetEmpty();
+			for (uint32 Index = 0; Index < NumPositions; ++Index)
+			{
+				const FVector3& Pos = Vertices[Index].Pos;
+				const FVector4 NewPos = Transpose.Transform({Pos.x, Pos.y, Pos.z, 1});
+				Transformed[Index].Pos = {{{NewPos.x, NewPos.y, NewPos.z}}};
+				Bounds.Add(Transformed[Index].Pos);
+			}
+		});
+	const FBox OneBounds = Bounds;
+	const double AoSTime = TimeInMs(NumIterations, [&](uint32) { TransformPositions(M, &Vertices[0].Pos, sizeof(FMeshVertex), NumPositions, &Transformed[0].Pos, sizeof(FMeshVertex), &Bounds); });
+	const double SoATime = TimeInMs(NumIterations, [&](uint32) { TransformPositions(M, X.data(), Y.data(), Z.data(), NumPositions, OutX.data(), OutY.data(), OutZ.data(), &Bounds); });
+	const double ThreadsTime = TimeInMs(NumIterations, [&](uint32) { TransformPositions(M, &Vertices[0].Pos, sizeof(FMeshVertex), NumPositions, &Transformed[0].Pos, sizeof(FMeshVertex), &Bounds, 0); });
+
+	printf("Transforming %u positions with bounds: %.3f ms one at a time, %.3f ms batched, %.3f ms batched x/y/z streams, %.3f ms batched on %u threads; bounds differ by %g\n",
+		NumPositions, OneTime, AoSTime, SoATime, ThreadsTime, GetNumberOfCores(), max(OneBounds.Min.Sub(Bounds.Min).Length(), OneBounds.Max.Sub(Bounds.Max).Length()));
+}
+
+// World matrices for NumNodes random nodes, each parented to one of the 8 before it: composing FTransforms versus
+// multiplying their matrices down the hierarchy
+static void TestHierarchy(uint32 NumNodes, uint32 NumIterations)
+{
+	std::vector<FTransform> Locals(NumNodes);
+	std::vector<int32> Parents(NumNodes);
+	for (uint32 Index = 0; Index < NumNodes; ++Index)
+	{
+		FTransform& Local = Locals[Index];
+		Local = FTransform::GetIdentity();
+		Local.Rotation = FQuaternion::FromAxisAngle(FVector3({{{GetRandomFloat(-1, 1), GetRandomFloat(-1, 1), GetRandomFloat(-1, 1)}}}).GetNormalized(), GetRandomFloat(-3, 3));
+		Local.Translation = {{{GetRandomFloat(-1, 1), GetRandomFloat(-1, 1), GetRandomFloat(-1, 1)}}};
+		Parents[Index] = Index == 0 ? -1 : (int32)(Index - 1 - rand() % min(Index, 8u));
+	}
+
+	std::vector<FTransform> Worlds(NumNodes);
+	std::vector<FMatrix4x4> Matrices(NumNodes);
+	std::vector<FMatrix4x4> MatricesByMul(NumNodes);
+	const double TransformsTime = TimeInMs(NumIterations, [&](uint32) { UpdateWorldTransforms(Locals.data(), Parents.data(), NumNodes, Worlds.data(), Matrices.data()); });
+	const double MatricesTime = TimeInMs(NumIterations, [&](uint32)
+		{
+			for (uint32 Index = 0; Index < NumNodes; ++Index)
+			{
+				const FMatrix4x4 Local = Locals[Index].ToMatrix();
+				MatricesByMul[Index] = Parents[Index] < 0 ? Local : Local.Mul(MatricesByMul[Parents[Index]]);
+			}
+		});
+
+	float MaxDifference = 0;
+	for (uint32 Index = 0; Index < NumNodes; ++Index)
+	{
+		for (uint32 Value = 0; Value < 16; ++Value)
+		{
+			MaxDifference = max(MaxDifference, fabs(Matrices[Index].Values[Value] - MatricesByMul[Index].Values[Value]));
+		}
+	}
+
+	printf("World matrices for %u nodes: %.3f ms composing transforms, %.3f ms multiplying matrices (max difference %g)\n",
+		NumNodes, TransformsTime, MatricesTime, MaxDifference);
+}
+
+// Checks Obj::ReadFloat() matches strtof() bit for bit on random values printed the ways exporters do, and gives back
+// every float printed with %.9g; then times it against strtof() and atof()
+static void TestFloatParsing(uint32 NumValues, uint32 NumIterations)
+{
+	// Short fixed point (the fast path), round trip precision, exponents, and mantissas too long for the fast path
+	static const char* Formats[] = {"%.4f", "%.6f", "%.9g", "%e", "%.20f"};
+	const uint32 RoundTripFormat = 2;
+	std::string Text;
+	std::vector<float> Values(NumValues);
+	std::vector<uint32> Offsets(NumValues);
+	for (uint32 Index = 0; Index < NumValues; ++Index)
+	{
+		const int32 Exponent = rand() % 41 - 20;
+		Values[Index] = ldexpf(GetRandomFloat(-1, 1), Exponent);
+		char Number[64];
+		sprintf_s(Number, sizeof(Number), Formats[Index % _countof(Formats)], Values[Index]);
+		Offsets[Index] = (uint32)Text.size();
+		Text += Number;
+		Text += ' ';
+	}
+
+	uint32 NumMismatches = 0;
+	uint32 NumRoundTrips = 0;
+	uint32 NumRoundTripErrors = 0;
+	for (uint32 Index = 0; Index < NumValues; ++Index)
+	{
+		const char* Line = Text.c_str() + Offsets[Index];
+		char* End = nullptr;
+		const float Expected = strtof(Line, &End);
+		const float Parsed = Obj::ReadFloat(Line);
+		NumMismatches += (memcmp(&Expected, &Parsed, sizeof(float)) || Line != End) ? 1 : 0;
+		if (Index % _countof(Formats) == RoundTripFormat)
+		{
+			++NumRoundTrips;
+			NumRoundTripErrors += memcmp(&Values[Index], &Parsed, sizeof(float)) ? 1 : 0;
+		}
+	}
+
+	// Results go through Sink so the loops aren't optimized away
+	float Sink = 0;
+	const double ReadFloatTime = TimeInMs(NumIterations, [&](uint32)
+		{
+			for (uint32 Offset : Offsets)
+			{
+				const char* Line = Text.c_str() + Offset;
+				Sink += Obj::ReadFloat(Line);
+			}
+		}) * 1000000.0 / NumValues;
+	const double StrtofTime = TimeInMs(NumIterations, [&](uint32)
+		{
+			for (uint32 Offset : Offsets)
+			{
+				Sink += strtof(Text.c_str() + Offset, nullptr);
+			}
+		}) * 1000000.0 / NumValues;
+	const double AtofTime = TimeInMs(NumIterations, [&](uint32)
+		{
+			for (uint32 Offset : Offsets)
+			{
+				Sink += (float)atof(Text.c_str() + Offset);
+			}
+		}) * 1000000.0 / NumValues;
+
+	printf("Parsing %u floats (ns each): ReadFloat %.1f, strtof %.1f, atof %.1f; %u differ from strtof, %u of %u %%.9g values don't round trip; checksum %g\n",
+		NumValues, ReadFloatTime, StrtofTime, AtofTime, NumMismatches, NumRoundTripErrors, NumRoundTrips, Sink);
+	verify(NumMismatches == 0 && NumRoundTripErrors == 0);
+}
+
+// Round trips NumVertices random vertices through QuantizeVertices()/DequantizeVertex() and checks every error is
+// within what the quantization step allows, then times quantizing
+static void TestQuantization(uint32 NumVertices, uint32 NumIterations)
+{
+	std::vector<FMeshVertex> Vertices(NumVertices);
+	for (uint32 Index = 0; Index < NumVertices; ++Index)
+	{
+		FMeshVertex& Vertex = Vertices[Index];
+		Vertex.Pos = {{{GetRandomFloat(-50, 50), GetRandomFloat(0, 3), GetRandomFloat(-1000, 1000)}}};
+		Vertex.UV = {{GetRandomFloat(-4, 4), GetRandomFloat(0, 1)}};
+
+		// The first six are the axes and every fourth lies between two of them, where the octahedral encoding folds
+		FVector3 Normal = {{{GetRandomFloat(-1, 1), GetRandomFloat(-1, 1), GetRandomFloat(-1, 1)}}};
+		if (Index % 4 == 0)
+		{
+			Normal.Values[rand() % 3] = 0;
+		}
+		if (Index < 6)
+		{
+			Normal = {{{0, 0, 0}}};
+			Normal.Values[Index % 3] = Index < 3 ? 1.0f : -1.0f;
+		}
+		Vertex.Normal = Normal.GetNormalized();
+	}
+
+	const FVertexQuantization Quantization = ComputeVertexQuantization(Vertices.data(), NumVertices);
+	std::vector<FQuantizedVertex> Quantized(NumVertices);
+	const double Time = TimeInMs(NumIterations, [&](uint32) { QuantizeVertices(Vertices.data(), NumVertices, Quantization, Quantized.data()); });
+
+	// Positions round to the nearest of 65536 steps across the bounds. The octahedral normal is off by at most half of
+	// a 1/127 step in x and y, which moves the point on the octahedron by sqrt(1.5)/127 at most, and the octahedron is
+	// at least 1/sqrt(3) from the center, so the angle is under sqrt(4.5)/127 radians (0.96 degrees). Half floats are
+	// off by at most 2^-11 of the value, or of 2^-14 for denormals.
+	const float MaxNormalError = sqrtf(4.5f) / 127.0f;
+	float MaxPosErrorInSteps = 0;
+	float MaxNormalErrorFound = 0;
+	float MaxUVErrorInUlps = 0;
+	uint32 NumOutOfBounds = 0;
+	for (uint32 Index = 0; Index < NumVertices; ++Index)
+	{
+		const FMeshVertex& In = Vertices[Index];
+		const FMeshVertex Out = DequantizeVertex(Quantized[Index], Quantization);
+		bool bInBounds = true;
+		for (uint32 Axis = 0; Axis < 3; ++Axis)
+		{
+			// Plus a few float roundings at the bounds' magnitude from dequantizing
+			const float Step = Quantization.Scale.Values[Axis] / 65535.0f;
+			const float Slack = 4.0f * FLT_EPSILON * (fabs(Quantization.Bias.Values[Axis]) + Quantization.Scale.Values[Axis]);
+			const float Error = fabs(Out.Pos.Values[Axis] - In.Pos.Values[Axis]);
+			MaxPosErrorInSteps = max(MaxPosErrorInSteps, Error / Step);
+			bInBounds = bInBounds && Error <= 0.5f * Step + Slack;
+		}
+		const float CosError = min(In.Normal.Dot(Out.Normal) / Out.Normal.Length(), 1.0f);
+		const float NormalError = acosf(CosError);
+		MaxNormalErrorFound = max(MaxNormalErrorFound, NormalError);
+		bInBounds = bInBounds && NormalError <= MaxNormalError * 1.001f;
+		for (uint32 Component = 0; Component < 2; ++Component)
+		{
+			const float Value = Component ? In.UV.v : In.UV.u;
+			const float Error = fabs((Component ? Out.UV.v : Out.UV.u) - Value);
+			const float ErrorInUlps = Error / (max(fabs(Value), 1.0f / 16384.0f) / 2048.0f);
+			MaxUVErrorInUlps = max(MaxUVErrorInUlps, ErrorInUlps);
+			bInBounds = bInBounds && ErrorInUlps <= 1.001f;
+		}
+		NumOutOfBounds += bInBounds ? 0 : 1;
+	}
+
+	printf("Quantizing %u vertices: %.3f ms, %u -> %u bytes per vertex (%u with tangents); max errors %.3f position steps, %.3f degrees of normal (bound %.3f), %.3f half float ulps of uv; %u vertices out of bounds\n",
+		NumVertices, Time, (uint32)sizeof(FMeshVertex), (uint32)sizeof(FQuantizedVertex), (uint32)sizeof(FQuantizedTangentVertex),
+		MaxPosErrorInSteps, MaxNormalErrorFound * 180.0f / 3.14159265f, MaxNormalError * 180.0f / 3.14159265f, MaxUVErrorInUlps, NumOutOfBounds);
+	verify(NumOutOfBounds == 0);
+}
+
+// Splits a sphere of NumRings * NumSegments * 2 triangles into meshlets and checks every triangle lands in one and that
+// the normal cones only cull meshlets facing away from the starting view; then times building, culling the meshlets
+// and backface testing every triangle instead
+static void TestMeshlets(uint32 NumRings, uint32 NumSegments, uint32 NumIterations, float Aspect)
+{
+	const float Radius = 3.0f;
+	FIndexedMesh Mesh;
+	Mesh.Vertices.resize((NumRings + 1) * NumSegments);
+	for (uint32 Ring = 0; Ring <= NumRings; ++Ring)
+	{
+		const float Theta = 3.14159265f * Ring / NumRings;
+		for (uint32 Segment = 0; Segment < NumSegments; ++Segment)
+		{
+			const float Phi = 2.0f * 3.14159265f * Segment / NumSegments;
+			FMeshVertex& Vertex = Mesh.Vertices[Ring * NumSegments + Segment];
+			MemZero(Vertex);
+			Vertex.Normal = {{{sinf(Theta) * cosf(Phi), cosf(Theta), sinf(Theta) * sinf(Phi)}}};
+			Vertex.Pos = Vertex.Normal.Mul(Radius);
+		}
+	}
+
+	// Counter clockwise seen from outside; the rows at the poles are degenerate
+	Mesh.Indices.reserve(NumRings * NumSegments * 6);
+	for (uint32 Ring = 0; Ring < NumRings; ++Ring)
+	{
+		for (uint32 Segment = 0; Segment < NumSegments; ++Segment)
+		{
+			const uint32 Next = (Segment + 1) % NumSegments;
+			const uint32 Quad[4] = {Ring * NumSegments + Segment, Ring * NumSegments + Next, (Ring + 1) * NumSegments + Segment, (Ring + 1) * NumSegments + Next};
+			const uint32 Indices[6] = {Quad[0], Quad[1], Quad[2], Quad[1], Quad[3], Quad[2]};
+			Mesh.Indices.insert(Mesh.Indices.end(), Indices, Indices + 6);
+		}
+	}
+	const uint32 NumTriangles = Mesh.GetNumTriangles();
+
+	FMeshlets Meshlets;
+	double StartTime = GetTimeInMs();
+	BuildMeshlets(Mesh, Meshlets);
+	const double BuildTime = GetTimeInMs() - StartTime;
+
+	FMatrix4x4 View = FMatrix4x4::GetIdentity();
+	View.Rows[3] = GCameraPos;
+	const FMatrix4x4 Proj = CalculateProjectionMatrix(ToRadians(60), Aspect, 0.1f, 1000.0f);
+	const FFrustum Frustum = FFrustum::FromMatrix(View.Mul(Proj));
+	const FVector3 CameraPos = {{{GCameraPos.x, GCameraPos.y, GCameraPos.z}}};
+	std::vector<uint32> Visible;
+	const double CullTime = TimeInMs(NumIterations, [&](uint32) { CullMeshlets(Meshlets, Frustum, CameraPos, Visible); });
+
+	// Meshlets the frustum keeps but the cone culls must only have triangles facing away, give or take float rounding
+	// at the silhouette
+	std::vector<uint8> bVisible(Meshlets.Meshlets.size(), 0);
+	for (uint32 Index : Visible)
+	{
+		bVisible[Index] = 1;
+	}
+	auto GetVertexPos = [&](const FMeshlet& Meshlet, uint32 Triangle, uint32 Corner) -> const FVector3&
+	{
+		return Mesh.Vertices[Meshlets.Vertices[Meshlet.FirstVertex + Meshlets.Triangles[(Meshlet.FirstTriangle + Triangle) * 3 + Corner]]].Pos;
+	};
+	uint32 NumMeshletTriangles = 0;
+	uint32 NumVisibleTriangles = 0;
+	uint32 NumWronglyCulled = 0;
+	bool bWithinLimits = true;
+	for (uint32 Index = 0; Index < (uint32)Meshlets.Meshlets.size(); ++Index)
+	{
+		const FMeshlet& Meshlet = Meshlets.Meshlets[Index];
+		bWithinLimits = bWithinLimits && Meshlet.NumVertices <= 64 && Meshlet.NumTriangles <= 124;
+		NumMeshletTriangles += Meshlet.NumTriangles;
+		NumVisibleTriangles += bVisible[Index] ? Meshlet.NumTriangles : 0;
+		if (bVisible[Index] || !Frustum.IsSphereVisible(Meshlet.Center, Meshlet.Radius))
+		{
+			continue;
+		}
+
+		for (uint32 Triangle = 0; Triangle < Meshlet.NumTriangles; ++Triangle)
+		{
+			const FVector3& A = GetVertexPos(Meshlet, Triangle, 0);
+			const FVector3 Normal = GetVertexPos(Meshlet, Triangle, 1).Sub(A).Cross(GetVertexPos(Meshlet, Triangle, 2).Sub(A)).GetNormalized();
+			const FVector3 ToTriangle = A.Sub(CameraPos);
+			NumWronglyCulled += Normal.Dot(ToTriangle) < -1e-4f * ToTriangle.Length() ? 1 : 0;
+		}
+	}
+
+	// What the meshlets save the GPU from: a backface test per triangle
+	uint32 NumFrontFacing = 0;
+	const double TrianglesTime = TimeInMs(NumIterations, [&](uint32)
+		{
+			NumFrontFacing = 0;
+			for (uint32 Index = 0; Index < (uint32)Mesh.Indices.size(); Index += 3)
+			{
+				const FVector3& A = Mesh.Vertices[Mesh.Indices[Index + 0]].Pos;
+				const FVector3& B = Mesh.Vertices[Mesh.Indices[Index + 1]].Pos;
+				const FVector3& C = Mesh.Vertices[Mesh.Indices[Index + 2]].Pos;
+				NumFrontFacing += B.Sub(A).Cross(C.Sub(A)).Dot(A.Sub(CameraPos)) < 0 ? 1 : 0;
+			}
+		});
+
+	printf("Meshlets for %u triangles: %u meshlets built in %.1f ms, culled in %.3f ms to %u meshlets with %u triangles (%u front facing); "
+		"backface testing every triangle %.3f ms; %u triangles wrongly culled\n",
+		NumTriangles, (uint32)Meshlets.Meshlets.size(), BuildTime, CullTime, (uint32)Visible.size(), NumVisibleTriangles, NumFrontFacing, TrianglesTime, NumWronglyCulled);
+	verify(NumMeshletTriangles == NumTriangles && bWithinLimits && NumWronglyCulled == 0);
+}
+
+// Checks the batch normal encoders give the scalar results, reading from vertices and from a packed array whose last
+// group of four ends at the end of the allocation; then measures each encoding's angular error against its bound and
+// times scalar against batch
+static void TestNormalPacking(uint32 NumNormals, uint32 NumIterations)
+{
+	std::vector<FMeshVertex> Vertices(NumNormals);
+	std::vector<FVector3> Normals(NumNormals);
+	for (uint32 Index = 0; Index < NumNormals; ++Index)
+	{
+		FVector3 Normal = FVector3::GetZero();
+		while (Normal.Dot(Normal) < 0.01f)
+		{
+			Normal = {{{GetRandomFloat(-1, 1), GetRandomFloat(-1, 1), GetRandomFloat(-1, 1)}}};
+		}
+		MemZero(Vertices[Index]);
+		Vertices[Index].Normal = Normals[Index] = Normal.GetNormalized();
+	}
+
+	// 16 bit encodings are written to the low half of each entry
+	std::vector<uint32> Batch(NumNormals);
+	std::vector<uint32> Scalar(NumNormals);
+	bool bMatches = true;
+	bool bWithinBounds = true;
+	printf("Packing %u normals (M/s scalar -> batch; average, max and bound in degrees):", NumNormals);
+	auto Run = [&](const char* Name, auto BatchFunction, auto ScalarFunction, auto Decode, float MaxError)
+	{
+		Batch.assign(NumNormals, 0);
+		Scalar.assign(NumNormals, 0);
+		const double BatchTime = TimeInMs(NumIterations, [&](uint32) { BatchFunction(&Vertices[0].Normal, (uint32)sizeof(FMeshVertex), Batch.data()); });
+		const double ScalarTime = TimeInMs(NumIterations, [&](uint32)
+			{
+				for (uint32 Index = 0; Index < NumNormals; ++Index)
+				{
+					Scalar[Index] = ScalarFunction(Vertices[Index].Normal);
+				}
+			});
+		bMatches = bMatches && Batch == Scalar;
+		Batch.assign(NumNormals, 0);
+		BatchFunction(Normals.data(), (uint32)sizeof(FVector3), Batch.data());
+		bMatches = bMatches && Batch == Scalar;
+
+		double SumError = 0;
+		float MaxErrorFound = 0;
+		for (uint32 Index = 0; Index < NumNormals; ++Index)
+		{
+			// acosf() of a float dot product can't resolve the 16 bit encoding's errors
+			const FVector3 Decoded = Decode(Scalar[Index]);
+			const float Error = atan2f(Normals[Index].Cross(Decoded).Length(), Normals[Index].Dot(Decoded));
+			SumError += Error;
+			MaxErrorFound = max(MaxErrorFound, Error);
+		}
+		bWithinBounds = bWithinBounds && MaxErrorFound <= MaxError * 1.001f;
+
+		const float ToDegrees = 180.0f / 3.14159265f;
+		printf(" %s %.0f -> %.0f, %.4f %.4f %.4f;",
+			Name, NumNormals / (ScalarTime * 1000.0), NumNormals / (BatchTime * 1000.0), SumError / NumNormals * ToDegrees, MaxErrorFound * ToDegrees, MaxError * ToDegrees);
+	};
+
+	// PackNormalToU32() truncates, so the middle of each step is 0.5 up and every axis is off by at most 1/255. The
+	// octahedral ones are off by at most half a step in x and y, which is sqrt(4.5) steps of angle (see
+	// TestQuantization()).
+	Run("PackNormalToU32",
+		[&](const FVector3* In, uint32 Stride, uint32* Out) { PackNormalsToU32(In, Stride, NumNormals, Out, sizeof(uint32)); },
+		[](const FVector3& N) { return PackNormalToU32(N); },
+		[](uint32 Packed)
+		{
+			FVector3 N;
+			for (uint32 Axis = 0; Axis < 3; ++Axis)
+			{
+				N.Values[Axis] = (((Packed >> (Axis * 8)) & 0xff) + 0.5f) / 127.5f - 1.0f;
+			}
+			return N;
+		},
+		asinf(sqrtf(3.0f) / 255.0f));
+	Run("EncodeOctahedral16",
+		[&](const FVector3* In, uint32 Stride, uint32* Out) { EncodeNormalsOctahedral16(In, Stride, NumNormals, Out, sizeof(uint32)); },
+		[](const FVector3& N) { return EncodeOctahedral16(N); },
+		[](uint32 Packed) { return DecodeOctahedral16(Packed); },
+		sqrtf(4.5f) / 32767.0f);
+	Run("EncodeOctahedral8",
+		[&](const FVector3* In, uint32 Stride, uint32* Out) { EncodeNormalsOctahedral8(In, Stride, NumNormals, (uint16*)Out, sizeof(uint32)); },
+		[](const FVector3& N) { return (uint32)EncodeOctahedral8(N); },
+		[](uint32 Packed) { return DecodeOctahedral8((uint16)Packed); },
+		sqrtf(4.5f) / 127.0f);
+
+	printf(" batch %s scalar\n", bMatches ? "matches" : "DIFFERS from");
+	verify(bMatches && bWithinBounds);
+}
+
+// Same arrays bit for bit
+static bool IsSameObj(const Obj::FObj& A, const Obj::FObj& B)
+{
+	auto IsSame = [](const auto& X, const auto& Y)
+	{
+		return X.size() == Y.size() && (X.empty() || !memcmp(X.data(), Y.data(), X.size() * sizeof(X[0])));
+	};
+	if (!IsSame(A.Vs, B.Vs) || !IsSame(A.VTs, B.VTs) || !IsSame(A.VNs, B.VNs) || !IsSame(A.Faces, B.Faces) || !IsSame(A.MaterialRanges, B.MaterialRanges))
+	{
+		return false;
+	}
+	if (A.MaterialLibraries != B.MaterialLibraries || A.Materials.size() != B.Materials.size())
+	{
+		return false;
+	}
+	for (uint32 Index = 0; Index < (uint32)A.Materials.size(); ++Index)
+	{
+		if (A.Materials[Index].Name != B.Materials[Index].Name)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+// Times loading Filename with fgets(), mapped, and in parallel on 1, 2, 4... threads up to the number of cores, after
+// an untimed load so all of them find it in the file cache, and checks they give the same FObj
+static void TestLoading(const char* Filename)
+{
+	Obj::FObj Reference;
+	if (!Obj::Load(Filename, Reference, Obj::ELoadMode::Mapped))
+	{
+		printf("Can't load %s\n", Filename);
+		exit(1);
+	}
+
+	bool bSame = true;
+	auto TimeLoad = [&](Obj::ELoadMode Mode, uint32 NumThreads)
+	{
+		Obj::FObj Loaded;
+		const double StartTime = GetTimeInMs();
+		Obj::Load(Filename, Loaded, Mode, NumThreads);
+		const double Time = GetTimeInMs() - StartTime;
+		bSame = bSame && IsSameObj(Loaded, Reference);
+		return Time;
+	};
+	const double LinesTime = TimeLoad(Obj::ELoadMode::Lines, 0);
+	const double MappedTime = TimeLoad(Obj::ELoadMode::Mapped, 0);
+
+	printf("Loading %s (%u v, %u vt, %u vn, %u faces): lines %.0f ms, mapped %.0f ms, parallel",
+		Filename, (uint32)Reference.Vs.size(), (uint32)Reference.VTs.size(), (uint32)Reference.VNs.size(), (uint32)Reference.Faces.size(),
+		LinesTime, MappedTime);
+	const uint32 NumCores = GetNumberOfCores();
+	for (uint32 NumThreads = 1; NumThreads < NumCores * 2; NumThreads *= 2)
+	{
+		// Always ends with all the cores
+		NumThreads = min(NumThreads, NumCores);
+		const double ParallelTime = TimeLoad(Obj::ELoadMode::Parallel, NumThreads);
+		printf(" %u: %.0f ms (%.2fx),", NumThreads, ParallelTime, MappedTime / ParallelTime);
+	}
+	printf(" %s\n", bSame ? "same results" : "results DIFFER");
+	verify(bSame);
+}
+
+int main(int argc, char** argv)
+{
+	srand(1);
+	const float Aspect = 16.0f / 9.0f;
+	TestCulling(100000, 100, Aspect);
+	TestMatrixMath(1000);
+	TestTransforms(1000000, 20);
+	TestHierarchy(100000, 20);
+	TestFloatParsing(1000000, 10);
+	TestQuantization(1000000, 20);
+	TestMeshlets(500, 1000, 20, Aspect);
+	TestNormalPacking(1000000, 20);
+	if (argc > 1)
+	{
+		TestLoading(argv[1]);
+	}
+	printf("All mesh tests passed\n");
+	return 0;
+}